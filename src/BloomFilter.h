@@ -0,0 +1,101 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief 64 位键的布隆过滤器
+ * mayContain 返回 false 时一定不存在; 返回 true 时可能误判, 误判率随已置位的位数增长
+ */
+class BloomFilter {
+    std::vector<uint64_t> words;
+    size_t bitCount = 0;
+    int hashCount = 0;
+    /**
+     * @brief 已置位的位数, 重复插入同一个键不会增加
+     */
+    size_t setBits = 0;
+
+    static uint64_t mix(uint64_t x)
+    {
+        // splitmix64
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    template <typename Fn>
+    void forEachBit(uint64_t key, Fn &&fn) const
+    {
+        // 双重哈希: h1 + i * h2
+        uint64_t h1 = mix(key);
+        uint64_t h2 = mix(h1) | 1;
+        for (int i = 0; i < hashCount; i++) {
+            fn((h1 + i * h2) % bitCount);
+        }
+    }
+
+public:
+    /**
+     * @param bits 位数, 向上取整到 64 的倍数
+     * @param hashes 每个键设置的位数
+     */
+    BloomFilter(size_t bits = 1 << 16, int hashes = 4)
+        : words((bits + 63) / 64), bitCount(((bits + 63) / 64) * 64), hashCount(hashes < 1 ? 1 : hashes)
+    {
+        if (bitCount == 0) {
+            words.resize(1);
+            bitCount = 64;
+        }
+    }
+
+    void insert(uint64_t key)
+    {
+        forEachBit(key, [this](size_t bit) {
+            uint64_t mask = 1ull << (bit % 64);
+            if (!(words[bit / 64] & mask)) {
+                words[bit / 64] |= mask;
+                setBits++;
+            }
+        });
+    }
+
+    bool mayContain(uint64_t key) const
+    {
+        bool all = true;
+        forEachBit(key, [&](size_t bit) { all = all && (words[bit / 64] >> (bit % 64) & 1); });
+        return all;
+    }
+
+    void clear()
+    {
+        std::fill(words.begin(), words.end(), 0);
+        setBits = 0;
+    }
+
+    size_t bits() const
+    {
+        return bitCount;
+    }
+
+    int hashes() const
+    {
+        return hashCount;
+    }
+
+    size_t setBitCount() const
+    {
+        return setBits;
+    }
+
+    /**
+     * @brief 按实际置位比例估算的误判率 (置位数 / 位数)^k, 不受重复插入影响
+     */
+    double falsePositiveRate() const
+    {
+        return std::pow((double)setBits / (double)bitCount, hashCount);
+    }
+};
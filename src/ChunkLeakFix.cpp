@@ -1,55 +1,307 @@
 // Copyright (c) 2024, The Endstone Project. (https://endstone.dev) All Rights Reserved.
 
+#include "CleanupRules.h"
+#include "Config.h"
 #include "HookManager/HookManager.hpp"
+#include "MapCleanup.h"
+#include "MapData.h"
+#include "MapSnapshot.h"
+#include "Reclaimer.h"
+#include "ReconnectGrace.h"
+#include "ServerThread.h"
+#include "ShadowVerify.h"
+#include "Signatures.h"
+#include "TickMonitor.h"
+#include "Trace.h"
+#include "TrackerCap.h"
+#include "TrackerFilter.h"
+#include "UpdateThrottle.h"
 #include "Utils.h"
 #include "endstone/plugin/plugin.h"
 
 #include <endstone/color_format.h>
 #include <endstone/command/plugin_command.h>
+#include <endstone/event/player/player_join_event.h>
 #include <endstone/event/server/server_command_event.h>
 #include <endstone/event/server/server_load_event.h>
+#include <endstone/level/dimension.h>
+#include <endstone/player.h>
 #include <endstone/plugin/plugin.h>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <concurrentqueue.h>
 #include <iostream>
 #include <memory>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
-class ServerNetworkHandler {};
-class ServerPlayer {};
-class ServerLevel {};
-class ServerMapDataManager {};
-struct ActorUniqueID {
-public:
-    int64_t id{};
+HookInstance *h = nullptr;
+HookInstance *hLeaveTrace = nullptr;
+HookInstance *hAddTracker = nullptr;
+HookInstance *hActorRemove = nullptr;
+HookInstance *hItemFrameRemoved = nullptr;
+HookInstance *hNextUpdatePacket = nullptr;
+HookInstance *hGetUpdatePacket = nullptr;
+PluginConfig config;
+TrackerFilter trackerFilter;
+TraceRecorder traceRecorder;
+TickMonitor tickMonitor;
+CleanupRegistry cleanupRules;
+Reclaimer<std::shared_ptr<MapItemTrackedActor>> trackerReclaimer;
+UpdateThrottle updateThrottle;
+TrackerCap trackerCap;
+MapSnapshot mapSnapshot;
+ShadowVerifier shadowVerifier;
+ReconnectGrace reconnectGrace;
+ServerLevel *currentLevel = nullptr;
+
+enum class ResolveState {
+    Pending,
+    Resolving,
+    Ready,
+    Failed
 };
-class MapItemSavedData {};
-class MapItemTrackedActor {};
+std::atomic<ResolveState> resolveState{ResolveState::Pending};
 
-HookInstance *h = nullptr;
+/**
+ * @brief 离开的玩家, 由 _onPlayerLeft 放入队列, 在 tick 任务中处理
+ * _onPlayerLeft 所在的线程不一定是服务器线程, 队列是它与清理代码之间唯一共享的数据
+ */
+struct PendingSweep {
+    ServerLevel *level;
+    int64_t uniqueId;
+};
+moodycamel::ConcurrentQueue<PendingSweep> pendingSweeps;
 
-typedef const ActorUniqueID *(*Actor_getOrCreateUniqueID)(ServerPlayer *_this);
+typedef const ActorUniqueID *(*Actor_getOrCreateUniqueID)(Actor *_this);
 Actor_getOrCreateUniqueID getOrCreateUniqueID = nullptr;
 
 typedef ServerMapDataManager *(*ServerLevel_getMapDataManager)(ServerLevel *_this);
 ServerLevel_getMapDataManager _getMapDataManager = nullptr;
 
+__declspec(noinline) std::shared_ptr<MapItemTrackedActor> *addTrackedMapEntity(
+    MapItemSavedData *_this, std::shared_ptr<MapItemTrackedActor> *result, Actor *entity, int decorationType)
+{
+    auto ori = hAddTracker->oriForSign(addTrackedMapEntity);
+    auto ret = ori(_this, result, entity, decorationType);
+    if (entity) {
+        currentLevel = MapLayout::level(entity);
+    }
+    if (ret && *ret) {
+        auto trackedId = MapLayout::trackedId(ret->get());
+        trackerFilter.onTrackerAdded(trackedId);
+        if (trackerCap.enabled()) {
+            trackerCap.onAdded(_this, ret->get());
+        }
+        traceRecorder.record(TraceEvent::TrackerAdd, trackedId, (uint64_t)(uintptr_t)_this);
+    }
+    return ret;
+}
+
+endstone::Logger &getLogger();
+
+SweepResult runCleanup(const CleanupContext &ctx)
+{
+    auto begin = std::chrono::steady_clock::now();
+    auto result = cleanupRules.run(ctx);
+    if (result.sweeps) {
+        tickMonitor.addCleanup(std::chrono::steady_clock::now() - begin, result);
+    }
+    return result;
+}
+
+/**
+ * @brief 清理跟踪指定实体的所有地图跟踪者, 只能在服务器线程调用
+ * @param playerLeft 由玩家离开触发
+ */
+void cleanupActor(ServerLevel *level, int64_t uniqueId, bool playerLeft = false)
+{
+    assert(ServerThread::isCurrent());
+    CleanupContext ctx{level, _getMapDataManager(level), uniqueId};
+    ctx.playerLeft = playerLeft;
+    auto result = runCleanup(ctx);
+    if (!shadowVerifier.sample()) {
+        return;
+    }
+    auto begin = std::chrono::steady_clock::now();
+    auto reference = shadowVerifier.verify(ctx.mapData, uniqueId, result);
+    tickMonitor.addMaintenance(std::chrono::steady_clock::now() - begin);
+    if (reference.removed) {
+        getLogger().warning("Shadow check: the optimized cleanup {} for UniqueID {} but {} trackers were left "
+                            "behind, removed them",
+                            result.sweeps ? "ran" : "was skipped", uniqueId, reference.removed);
+    }
+}
+
 __declspec(noinline) void _onPlayerLeft(ServerNetworkHandler *_this, ServerPlayer *player, bool skipMessage)
 {
     auto ori = h->oriForSign(_onPlayerLeft);
     if (!player) {
         return;
     }
-    ServerLevel *level = dAccess<ServerLevel *>(player, 0x1d8);
-    auto manager = _getMapDataManager(level);
-    auto &allMapData = dAccess<std::unordered_map<ActorUniqueID, std::unique_ptr<MapItemSavedData>>>(manager, 0x70);
-    for (auto &[id, data] : allMapData) {
-        auto &v = dAccess<std::vector<std::shared_ptr<MapItemTrackedActor>>>(data.get(), 0x60);
-        std::erase_if(v, [player](auto &ptr) {
-            return dAccess<ActorUniqueID>(ptr.get(), 0x8).id == getOrCreateUniqueID(player)->id;
-        });
+    // 只复制 UniqueID 放入队列, 不在这里访问地图数据和插件的其他状态
+    pendingSweeps.enqueue({MapLayout::level(player), getOrCreateUniqueID((Actor *)player)->id});
+    return ori(_this, player, skipMessage);
+}
+
+// 录制挂在同一个目标上, 优先级更高, 先于清理执行
+__declspec(noinline) void _onPlayerLeftTrace(ServerNetworkHandler *_this, ServerPlayer *player, bool skipMessage)
+{
+    auto ori = hLeaveTrace->oriForSign(_onPlayerLeftTrace);
+    if (player) {
+        traceRecorder.record(TraceEvent::Leave, getOrCreateUniqueID((Actor *)player)->id);
     }
     return ori(_this, player, skipMessage);
 }
 
+__declspec(noinline) void actorRemove(Actor *_this)
+{
+    auto ori = hActorRemove->oriForSign(actorRemove);
+    // 过滤器未启用时每个实体移除都要遍历所有地图, 代价太高, 此时跳过
+    if (_this && trackerFilter.isArmed()) {
+        // 没有 UniqueID 的实体不可能被跟踪
+        auto uniqueId = MapLayout::actorUniqueId(_this);
+        if (uniqueId != -1 && trackerFilter.mayTrack(uniqueId)) {
+            cleanupActor(MapLayout::level(_this), uniqueId);
+        }
+    }
+    return ori(_this);
+}
+
+__declspec(noinline) void itemFrameRemoved(BlockActor *_this, BlockSource *region)
+{
+    auto ori = hItemFrameRemoved->oriForSign(itemFrameRemoved);
+    if (_this && region) {
+        ServerLevel *level = MapLayout::regionLevel(region);
+        CleanupContext ctx{level, _getMapDataManager(level)};
+        ctx.target = CleanupTarget::Block;
+        ctx.blockPos = MapLayout::blockActorPos(_this);
+        ctx.dimension = MapLayout::regionDimension(region);
+        runCleanup(ctx);
+    }
+    return ori(_this, region);
+}
+
+bool throttleEnabled()
+{
+    return config.trackerThrottle && config.mapOriginOffset >= 0 && config.mapScaleOffset >= 0;
+}
+
+// 返回 std::unique_ptr<Packet>, 只记录更新时间, 不改变结果
+__declspec(noinline) void **nextUpdatePacket(MapItemTrackedActor *_this, void **result, MapItemSavedData *data)
+{
+    auto ori = hNextUpdatePacket->oriForSign(nextUpdatePacket);
+    if (_this && data && trackerCap.enabled()) {
+        trackerCap.touch(data, _this);
+    }
+    return ori(_this, result, data);
+}
+
+// 返回 std::unique_ptr<Packet>, 在跟踪列表中找到 actor 的跟踪者后调用 nextUpdatePacket
+// actor 没有跟踪者时原函数同样返回空指针, 跳过的 tick 按这种情况处理, 跟踪者的改动留到下一次更新
+__declspec(noinline) void **getUpdatePacket(MapItemSavedData *_this, void **result, void *item, void *level,
+                                            Actor *actor)
+{
+    auto ori = hGetUpdatePacket->oriForSign(getUpdatePacket);
+    if (_this && actor && throttleEnabled() && !updateThrottle.allow(getOrCreateUniqueID(actor)->id, _this)) {
+        *result = nullptr;
+        return result;
+    }
+    return ori(_this, result, item, level, actor);
+}
+
+/**
+ * @brief 在服务器 tick 中处理离开玩家的队列, 离开的清理只在这里进行
+ */
+void drainPendingSweeps()
+{
+    PendingSweep sweep;
+    while (pendingSweeps.try_dequeue(sweep)) {
+        currentLevel = sweep.level;
+        if (reconnectGrace.enabled()) {
+            reconnectGrace.park(sweep.level, sweep.uniqueId);
+        }
+        else {
+            cleanupActor(sweep.level, sweep.uniqueId, true);
+        }
+    }
+}
+
+void tickTrackerFilter()
+{
+    if (resolveState != ResolveState::Ready || !currentLevel) {
+        return;
+    }
+    if (trackerFilter.needsRebuild(std::chrono::seconds(config.bloomRebuildSeconds),
+                                   config.bloomMaxFalsePositiveRate)) {
+        auto begin = std::chrono::steady_clock::now();
+        trackerFilter.rebuild(_getMapDataManager(currentLevel));
+        tickMonitor.addMaintenance(std::chrono::steady_clock::now() - begin);
+    }
+}
+
+/**
+ * @brief 依次添加内置特征码和 config.json 中为该函数提供的特征码
+ * @return 是否有可尝试的特征码
+ */
+bool addSignPatterns(SignCode &sign, const SigDef &def)
+{
+    bool any = false;
+    if (def.pattern) {
+        sign << def.pattern;
+        any = true;
+    }
+    if (auto it = config.signatures.find(def.name); it != config.signatures.end()) {
+        for (auto &pattern : it->second) {
+            sign << pattern.c_str();
+            any = true;
+        }
+    }
+    return any;
+}
+
+/**
+ * @brief 添加并开启Hook, 两步的耗时记入启动分析
+ * @param out 保存Hook的全局变量, 在开启之前写入, 开启后立即进入的回调也能通过它调用原函数; 失败时置为 nullptr
+ * @return 是否成功
+ */
+bool installHook(HookInstance *&out, uintptr_t ptr, void *detour, const char *name, int priority = 0)
+{
+    using clock = std::chrono::steady_clock;
+    auto begin = clock::now();
+    auto hook = HookManager::getInstance()->addHook(ptr, detour, name, priority);
+    auto added = clock::now();
+    out = hook;
+    bool ok = hook && hook->hook();
+    auto enabled = clock::now();
+    startupProfiler().recordHook({name, std::chrono::duration<double, std::milli>(added - begin).count(),
+                                  std::chrono::duration<double, std::milli>(enabled - added).count(), ok});
+    if (!ok) {
+        out = nullptr;
+    }
+    return ok;
+}
+
+/**
+ * @brief 查找并安装一个可选功能的Hook, 没有配置特征码或查找失败时返回 false
+ */
+template <typename T>
+bool installOptionalHook(HookInstance *&out, const SigDef &def, T detour)
+{
+    SignCode sign(def.name);
+    if (!addSignPatterns(sign, def)) {
+        getLogger().info("No signature configured for {}, the feature using it is disabled", def.name);
+        return false;
+    }
+    if (!sign) {
+        return false;
+    }
+    return installHook(out, *sign, (void *)detour, def.name);
+}
+
 namespace Hook {
 class PluginDescriptionBuilderImpl : public endstone::detail::PluginDescriptionBuilder {
 public:
@@ -60,6 +312,13 @@ public:
         website = "https://github.com/dreamguxiang/ChunkLeakFix";
         authors = {"dreamguxiang <guxiang@litebds.com>"};
         contributors = {};
+        command("chunkleakfix")
+            .description("Show ChunkLeakFix diagnostics")
+            .usages("/chunkleakfix (stats|snapshot)<action: ChunkLeakFixAction>")
+            .permissions("chunk_leak_fix.command");
+        permission("chunk_leak_fix.command")
+            .description("Allows the user to use the /chunkleakfix command")
+            .default_(endstone::PermissionDefault::Operator);
     }
 };
 
@@ -83,24 +342,385 @@ public:
 
     virtual void onLoad() override
     {
-        SignCode sign1("ServerNetworkHandler::_onPlayerLeft");
-        sign1
-            << "48 85 D2 0F 84 ? ? ? ? 48 89 5C 24 ? 55 56 57 41 54 41 55 41 56 41 57 48 8D AC 24 ? ? ? ? 48 81 EC 70 "
-               "02 00 00";
-        if (sign1) {
-            h = HookManager::getInstance()->addHook(*sign1, &_onPlayerLeft, "_onPlayerLeft");
-            h->hook();
+        startupProfiler().start();
+        config = loadConfig(getDataFolder() / "config.json");
+        trackerFilter.configure(config.bloomBits, config.bloomHashes);
+        MapLayout::mapDimensionOffset = config.mapDimensionOffset;
+        MapLayout::blockActorPositionOffset = config.blockActorPositionOffset;
+        MapLayout::blockSourceLevelOffset = config.blockSourceLevelOffset;
+        MapLayout::blockSourceDimensionOffset = config.blockSourceDimensionOffset;
+        MapLayout::dimensionIdOffset = config.dimensionIdOffset;
+        MapLayout::actorUniqueIdOffset = config.actorUniqueIdOffset;
+        MapLayout::mapOriginOffset = config.mapOriginOffset;
+        MapLayout::mapScaleOffset = config.mapScaleOffset;
+        MapLayout::mapPixelsOffset = config.mapPixelsOffset;
+        updateThrottle.configure(config.throttleTiers, config.throttleHandInterval);
+        trackerCap.configure((size_t)std::max(0, config.softMaxTrackersPerMap));
+        shadowVerifier.configure(config.shadowSampleRate);
+        reconnectGrace.configure(std::chrono::seconds(std::max(0, config.reconnectGraceSeconds)));
+        registerBuiltinRules(cleanupRules);
+        mapTrackers(cleanupRules).setPrefilter([](const CleanupContext &ctx) {
+            return ctx.target == CleanupTarget::Block || trackerFilter.mayTrack(ctx.uniqueId);
+        });
+        if (config.asyncResolve) {
+            resolveThread_ = std::thread([this] {
+                resolveSignatures();
+                sigIndex().release();
+                logStartupProfile();
+            });
+            return;
+        }
+        resolveSignatures();
+        sigIndex().release();
+        logStartupProfile();
+    }
+
+    virtual void onEnable() override
+    {
+        if (resolveState == ResolveState::Resolving) {
+            getLogger().info("Signatures are still being resolved in the background");
+        }
+        if (config.bloomFilter) {
+            getServer().getScheduler().runTaskTimer(*this, [] { tickTrackerFilter(); }, 20, 20);
+        }
+        tickMonitor.setBudget(config.tickBudgetMs);
+        tickMonitor.setEnabled(config.tickMonitor);
+        trackerReclaimer.start(parseReclaimMode(config.reclaimMode));
+        if (trackerReclaimer.mode() != ReclaimMode::Immediate) {
+            mapTrackers(cleanupRules).setRetire([](std::shared_ptr<MapItemTrackedActor> &&tracker) {
+                trackerReclaimer.retire(std::move(tracker));
+            });
+        }
+        // 快照可以随时由命令开始, tick 任务总是运行
+        getServer().getScheduler().runTaskTimer(*this, [this] { onServerTick(); }, 1, 1);
+        if (config.snapshotIntervalSeconds > 0) {
+            auto period = (uint64_t)config.snapshotIntervalSeconds * 20;
+            getServer().getScheduler().runTaskTimer(*this, [this] { startSnapshot(nullptr); }, period, period);
+        }
+        if (config.traceRecord && !traceRecorder.open(getDataFolder() / config.traceFile)) {
+            getLogger().error("Failed to open trace file {}", config.traceFile);
+        }
+        if (traceRecorder.isOpen()) {
+            mapTrackers(cleanupRules)
+                .setObserver([](const std::shared_ptr<MapItemTrackedActor> &tracker, const MapItemSavedData *data,
+                                const CleanupContext &ctx) {
+                    if (!ctx.playerLeft) {
+                        traceRecorder.record(TraceEvent::TrackerRemove, MapLayout::trackedId(tracker.get()),
+                                             (uint64_t)(uintptr_t)data);
+                    }
+                });
+        }
+        if (traceRecorder.isOpen() || reconnectGrace.enabled()) {
+            registerEvent(&Entry::onPlayerJoin, *this);
+        }
+    }
+
+    void onServerTick()
+    {
+        ServerThread::bind();
+        if (config.tickMonitor) {
+            if (auto overrun = tickMonitor.onTick()) {
+                getLogger().warning("Map cleanup made a tick overrun: tick took {:.1f} ms, cleanup {:.1f} ms "
+                                    "({} sweeps over {} maps and {} trackers, {} removed)",
+                                    overrun->tickMs, overrun->cleanupMs, overrun->sweeps, overrun->maps,
+                                    overrun->trackers, overrun->removed);
+            }
+        }
+        drainPendingSweeps();
+        reconnectGrace.takeExpired([](ServerLevel *level, int64_t uniqueId) { cleanupActor(level, uniqueId, true); });
+        trackerReclaimer.flush();
+        if (throttleEnabled()) {
+            updateThrottle.onTick();
+            if (++throttleRefreshTicks_ >= 10) {
+                throttleRefreshTicks_ = 0;
+                refreshThrottleViewers();
+            }
+        }
+        if (config.cleanupOnDimensionChange && config.mapDimensionOffset >= 0 && ++dimensionCheckTicks_ >= 20) {
+            dimensionCheckTicks_ = 0;
+            checkDimensionChanges();
+        }
+        if (hNextUpdatePacket && trackerCap.enabled() && currentLevel) {
+            enforceTrackerCap();
+        }
+        if (mapSnapshot.running() && currentLevel) {
+            if (mapSnapshot.step(_getMapDataManager(currentLevel), std::chrono::microseconds(config.snapshotBudgetUs))) {
+                getLogger().info("Map snapshot written to {}: {}", mapSnapshot.path().string(), mapSnapshot.summary());
+            }
+        }
+    }
+
+    /**
+     * @brief 背包中有已填充地图的在线玩家, 无法区分是哪一张, 所以视为持有所有地图
+     */
+    std::unordered_set<int64_t> onlineMapHolders()
+    {
+        std::unordered_set<int64_t> holders;
+        for (auto *player : getServer().getOnlinePlayers()) {
+            auto &inventory = player->getInventory();
+            for (int slot = 0; slot < inventory.getSize(); slot++) {
+                auto item = inventory.getItem(slot);
+                if (item && item->getType() == "minecraft:filled_map") {
+                    holders.insert(player->getId());
+                    break;
+                }
+            }
         }
-        SignCode sign2("Actor::getOrCreateUniqueID");
-        sign2 << "40 53 48 83 EC 30 4C 8B 51 ? BB 1A 48 1E A5";
+        return holders;
+    }
+
+    void enforceTrackerCap()
+    {
+        trackerCap.onTick();
+        auto manager = _getMapDataManager(currentLevel);
+        if (trackerCap.pending()) {
+            auto begin = std::chrono::steady_clock::now();
+            trackerCap.enforce(
+                manager, onlineMapHolders(),
+                [](const MapItemSavedData *data, std::shared_ptr<MapItemTrackedActor> &&tracker) {
+                    traceRecorder.record(TraceEvent::TrackerRemove, MapLayout::trackedId(tracker.get()),
+                                         (uint64_t)(uintptr_t)data);
+                    if (trackerReclaimer.mode() != ReclaimMode::Immediate) {
+                        trackerReclaimer.retire(std::move(tracker));
+                    }
+                    else {
+                        tracker.reset();
+                    }
+                });
+            tickMonitor.addMaintenance(std::chrono::steady_clock::now() - begin);
+        }
+        // 已被其他规则移除的跟踪者的记录每分钟清理一次
+        if (++trackerCapPruneTicks_ >= 1200) {
+            trackerCapPruneTicks_ = 0;
+            trackerCap.prune(manager);
+        }
+    }
+
+    /**
+     * @brief 找出维度与上次检查时不同的在线玩家, 移除其在其他维度地图上的跟踪者
+     * 不挂钩 ServerPlayer::changeDimension: 它的参数在各版本间不同, 无法用固定的签名安全地转发
+     */
+    void checkDimensionChanges()
+    {
+        if (resolveState != ResolveState::Ready || !currentLevel) {
+            return;
+        }
+        std::unordered_map<int64_t, int> dimensions;
+        for (auto *player : getServer().getOnlinePlayers()) {
+            // Dimension::Type 与 BDS 的 DimensionType 取值相同 (0 主世界, 1 下界, 2 末地)
+            int dimension = (int)player->getDimension().getType();
+            dimensions[player->getId()] = dimension;
+            auto last = playerDimensions_.find(player->getId());
+            if (last == playerDimensions_.end() || last->second == dimension) {
+                continue;
+            }
+            CleanupContext ctx{currentLevel, _getMapDataManager(currentLevel), player->getId()};
+            ctx.target = CleanupTarget::ActorDimension;
+            ctx.dimension = dimension;
+            runCleanup(ctx);
+        }
+        playerDimensions_ = std::move(dimensions);
+    }
+
+    /**
+     * @brief 开始一次地图快照, 由定时任务或命令触发
+     * @param sender 命令的发送者, 定时触发时为 nullptr
+     */
+    void startSnapshot(endstone::CommandSender *sender)
+    {
+        auto reply = [&](const std::string &message) {
+            if (sender) {
+                sender->sendMessage(message);
+            }
+            else {
+                getLogger().info("{}", message);
+            }
+        };
+        if (resolveState != ResolveState::Ready || !currentLevel) {
+            reply("Map snapshot is not available until a player has joined and hooks are installed");
+            return;
+        }
+        if (mapSnapshot.running()) {
+            reply("A map snapshot is already being written to " + mapSnapshot.path().string());
+            return;
+        }
+        auto epoch = std::chrono::system_clock::now().time_since_epoch();
+        auto file = getDataFolder() / config.snapshotDir
+                  / ("maps-" + std::to_string(std::chrono::duration_cast<std::chrono::seconds>(epoch).count())
+                     + ".json");
+        if (!mapSnapshot.begin(file, _getMapDataManager(currentLevel))) {
+            reply("Failed to open " + file.string());
+            return;
+        }
+        if (sender) {
+            sender->sendMessage("Writing map snapshot to " + file.string());
+        }
+    }
+
+    /**
+     * @brief 更新在线玩家的位置和手持物品, 玩家位置不需要精确, 每 10 tick 刷新一次
+     */
+    void refreshThrottleViewers()
+    {
+        std::unordered_map<int64_t, UpdateThrottle::Viewer> viewers;
+        for (auto *player : getServer().getOnlinePlayers()) {
+            auto location = player->getLocation();
+            auto item = player->getInventory().getItemInMainHand();
+            bool holdingMap = item && item->getType() == "minecraft:filled_map";
+            viewers[player->getId()] = {location.getX(), location.getZ(), holdingMap};
+        }
+        updateThrottle.setViewers(std::move(viewers));
+    }
+
+    bool onCommand(endstone::CommandSender &sender, const endstone::Command &command,
+                   const std::vector<std::string> &args) override
+    {
+        if (command.getName() != "chunkleakfix") {
+            return false;
+        }
+        if (args.empty() || args[0] == "stats") {
+            for (auto &line : tickMonitor.report()) {
+                sender.sendMessage(line);
+            }
+            for (auto &line : cleanupRules.report()) {
+                sender.sendMessage(line);
+            }
+            sender.sendMessage(trackerReclaimer.report());
+            if (reconnectGrace.enabled()) {
+                sender.sendMessage(reconnectGrace.report());
+            }
+            if (shadowVerifier.enabled()) {
+                sender.sendMessage(shadowVerifier.report());
+            }
+            if (hGetUpdatePacket && throttleEnabled()) {
+                sender.sendMessage(updateThrottle.report());
+            }
+            if (hNextUpdatePacket && trackerCap.enabled()) {
+                sender.sendMessage(trackerCap.report());
+            }
+            return true;
+        }
+        if (args[0] == "snapshot") {
+            startSnapshot(&sender);
+            return true;
+        }
+        return false;
+    }
+
+    void onPlayerJoin(endstone::PlayerJoinEvent &event)
+    {
+        auto uniqueId = event.getPlayer().getId();
+        traceRecorder.record(TraceEvent::Join, uniqueId);
+        // 同一个 tick 内离开又加入时, 离开还在队列中, 先转入宽限表再取消
+        drainPendingSweeps();
+        // 宽限期内重新加入, 服务端会继续使用原来的跟踪者
+        reconnectGrace.cancel(uniqueId);
+    }
+
+    virtual void onDisable() override
+    {
+        if (resolveThread_.joinable()) {
+            resolveThread_.join();
+        }
+        if (resolveState == ResolveState::Ready) {
+            // 还在宽限期内的玩家不会再回来触发清理, 卸载前清理掉
+            drainPendingSweeps();
+            reconnectGrace.takeAll([](ServerLevel *level, int64_t uniqueId) { cleanupActor(level, uniqueId, true); });
+        }
+        mapTrackers(cleanupRules).setRetire(nullptr);
+        trackerReclaimer.stop();
+        traceRecorder.close();
+    }
+
+private:
+    void logStartupProfile()
+    {
+        for (auto &line : startupProfiler().report()) {
+            getLogger().info("{}", line);
+        }
+    }
+
+    /**
+     * @brief 查找所有特征码, 辅助函数和 _onPlayerLeft 都找到后立即安装Hook
+     * 每次查找后检查是否超时, 超时后丢弃结果, 不再安装Hook
+     */
+    void resolveSignatures()
+    {
+        resolveState = ResolveState::Resolving;
+        if (config.sigIndex && !buildSigIndex()) {
+            getLogger().warning("Failed to build the signature index, falling back to linear scans");
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config.resolveTimeoutMs);
+        // 只限制可选Hook, 核心修复找到特征码后总会安装
+        bool warned = false;
+        auto timedOut = [&] {
+            if (std::chrono::steady_clock::now() < deadline) {
+                return false;
+            }
+            if (!warned) {
+                warned = true;
+                getLogger().warning("Signature resolution took longer than {} ms, remaining optional hooks are not "
+                                    "installed",
+                                    config.resolveTimeoutMs);
+            }
+            return true;
+        };
+
+        SignCode sign2(Sigs::getOrCreateUniqueID.name);
+        addSignPatterns(sign2, Sigs::getOrCreateUniqueID);
         getOrCreateUniqueID = (Actor_getOrCreateUniqueID)*sign2;
 
-        SignCode sign3("ServerLevel::_getMapDataManager");
-        sign3 << "48 83 EC 28 48 8B 81 C8 12 00 00 48 85 C0 74 05";
+        SignCode sign3(Sigs::getMapDataManager.name);
+        addSignPatterns(sign3, Sigs::getMapDataManager);
         _getMapDataManager = (ServerLevel_getMapDataManager)*sign3;
+
+        SignCode sign1(Sigs::onPlayerLeft.name);
+        addSignPatterns(sign1, Sigs::onPlayerLeft);
+        if (!sign1 || !sign2 || !sign3) {
+            resolveState = ResolveState::Failed;
+            return;
+        }
+        if (!installHook(h, *sign1, (void *)&_onPlayerLeft, "_onPlayerLeft")) {
+            resolveState = ResolveState::Failed;
+            return;
+        }
+        resolveState = ResolveState::Ready;
+
+        if (config.traceRecord) {
+            installHook(hLeaveTrace, *sign1, (void *)&_onPlayerLeftTrace, "_onPlayerLeft trace", 1);
+        }
+
+        if ((config.bloomFilter || config.traceRecord || trackerCap.enabled())
+            && !timedOut()) {
+            if (installOptionalHook(hAddTracker, Sigs::addTrackedMapEntity, &addTrackedMapEntity)
+                && config.bloomFilter) {
+                trackerFilter.setHookInstalled();
+            }
+        }
+        if (config.cleanupOnActorRemove && config.bloomFilter && config.actorUniqueIdOffset >= 0 && !timedOut()) {
+            installOptionalHook(hActorRemove, Sigs::actorRemove, &actorRemove);
+        }
+        if (config.blockActorPositionOffset >= 0 && config.blockSourceLevelOffset >= 0
+            && config.blockSourceDimensionOffset >= 0 && config.dimensionIdOffset >= 0
+            && config.mapDimensionOffset >= 0 && !timedOut()) {
+            installOptionalHook(hItemFrameRemoved, Sigs::itemFrameRemoved, &itemFrameRemoved);
+        }
+        if (throttleEnabled() && !timedOut()) {
+            installOptionalHook(hGetUpdatePacket, Sigs::getUpdatePacket, &getUpdatePacket);
+        }
+        if (trackerCap.enabled() && hAddTracker && !timedOut()) {
+            installOptionalHook(hNextUpdatePacket, Sigs::nextUpdatePacket, &nextUpdatePacket);
+        }
     }
 
-private:
+    std::thread resolveThread_;
+    int throttleRefreshTicks_ = 0;
+    int trackerCapPruneTicks_ = 0;
+    int dimensionCheckTicks_ = 0;
+    /**
+     * @brief 上次检查时每个在线玩家所在的维度
+     */
+    std::unordered_map<int64_t, int> playerDimensions_;
     PluginDescriptionBuilderImpl builder;
     endstone::PluginDescription description_ = builder.build("chunk_leak_fix", "1.0.0");
 };
@@ -0,0 +1,281 @@
+#pragma once
+#include "MapCleanup.h"
+#include "MapData.h"
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 清理的对象
+ */
+enum class CleanupTarget {
+    /**
+     * @brief 玩家离开或实体被移除, 移除该实体的所有跟踪者
+     */
+    Actor,
+    /**
+     * @brief 玩家切换维度, 只移除其他维度地图上的跟踪者
+     */
+    ActorDimension,
+    /**
+     * @brief 物品展示框被破坏
+     */
+    Block,
+};
+
+/**
+ * @brief 一次清理的上下文, 规则根据这些信息判断元素是否应被移除
+ */
+struct CleanupContext {
+    ServerLevel *level = nullptr;
+    ServerMapDataManager *mapData = nullptr;
+    /**
+     * @brief 离开 / 被移除的实体, target 为 Actor 时有效
+     */
+    int64_t uniqueId = 0;
+    CleanupTarget target = CleanupTarget::Actor;
+    /**
+     * @brief 被移除的方块实体位置, target 为 Block 时有效
+     */
+    BlockPos blockPos{};
+    /**
+     * @brief target 为 ActorDimension 时是玩家要前往的维度, 为 Block 时是方块实体所在的维度
+     */
+    int dimension = 0;
+    /**
+     * @brief 由玩家离开触发, 录制时不记录这类移除 (回放工具会自己模拟离开的清理)
+     */
+    bool playerLeft = false;
+};
+
+class CleanupContainerBase {
+public:
+    virtual ~CleanupContainerBase() = default;
+    virtual const char *name() const = 0;
+    virtual SweepResult run(const CleanupContext &ctx) = 0;
+    /**
+     * @brief 每条规则累计移除的元素数
+     */
+    virtual void forEachRule(const std::function<void(const char *rule, uint64_t removed)> &fn) const = 0;
+};
+
+/**
+ * @brief 一个可以从 level 访问到的容器 (Owner 持有的 std::vector<Element>) 以及作用在它上面的规则
+ * 同一容器的所有规则在一次遍历中执行, 元素满足任意一条规则即被移除
+ */
+template <typename Owner, typename Element>
+class CleanupContainer : public CleanupContainerBase {
+public:
+    using Visitor = std::function<void(Owner *owner, std::vector<Element> &elements)>;
+    /**
+     * @brief 对上下文中能访问到的每个容器实例调用 visitor
+     */
+    using Reach = void (*)(const CleanupContext &ctx, const Visitor &visitor);
+    using Predicate = bool (*)(const Element &element, const Owner *owner, const CleanupContext &ctx);
+    /**
+     * @brief 可选的快速判断, 返回 false 表示这次清理一定不会移除任何元素, 跳过遍历
+     */
+    using Prefilter = bool (*)(const CleanupContext &ctx);
+    /**
+     * @brief 可选的回收函数, 设置后被移除的元素移交给它, 而不是在遍历中直接析构
+     */
+    using Retire = void (*)(Element &&element);
+    /**
+     * @brief 可选的观察函数, 每个被移除的元素在移除前调用一次, 用于录制
+     */
+    using Observer = void (*)(const Element &element, const Owner *owner, const CleanupContext &ctx);
+
+private:
+    struct Rule {
+        const char *name;
+        Predicate predicate;
+        uint64_t removed = 0;
+    };
+
+    const char *containerName;
+    Reach reach;
+    Prefilter prefilter = nullptr;
+    Retire retire = nullptr;
+    Observer observer = nullptr;
+    std::vector<Rule> rules;
+
+    bool matches(const Element &element, const Owner *owner, const CleanupContext &ctx)
+    {
+        for (auto &rule : rules) {
+            if (rule.predicate(element, owner, ctx)) {
+                rule.removed++;
+                if (observer) {
+                    observer(element, owner, ctx);
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+public:
+    CleanupContainer(const char *name, Reach reach) : containerName(name), reach(reach) {}
+
+    const char *name() const override
+    {
+        return containerName;
+    }
+
+    void addRule(const char *name, Predicate predicate)
+    {
+        rules.push_back({name, predicate});
+    }
+
+    void setPrefilter(Prefilter fn)
+    {
+        prefilter = fn;
+    }
+
+    void setRetire(Retire fn)
+    {
+        retire = fn;
+    }
+
+    void setObserver(Observer fn)
+    {
+        observer = fn;
+    }
+
+    SweepResult run(const CleanupContext &ctx) override
+    {
+        SweepResult result;
+        if (rules.empty() || (prefilter && !prefilter(ctx))) {
+            return result;
+        }
+        result.sweeps = 1;
+        reach(ctx, [&](Owner *owner, std::vector<Element> &elements) {
+            result.maps++;
+            result.trackers += elements.size();
+            if (!retire) {
+                result.removed +=
+                    std::erase_if(elements, [&](const Element &element) { return matches(element, owner, ctx); });
+                return;
+            }
+            // 与 erase_if 相同的保序压缩, 但被移除的元素先移交出去, 最后 erase 的只是已被移走的空元素
+            size_t kept = 0;
+            for (size_t i = 0; i < elements.size(); i++) {
+                if (matches(elements[i], owner, ctx)) {
+                    retire(std::move(elements[i]));
+                    continue;
+                }
+                if (kept != i) {
+                    elements[kept] = std::move(elements[i]);
+                }
+                kept++;
+            }
+            result.removed += elements.size() - kept;
+            elements.erase(elements.begin() + kept, elements.end());
+        });
+        return result;
+    }
+
+    void forEachRule(const std::function<void(const char *rule, uint64_t removed)> &fn) const override
+    {
+        for (auto &rule : rules) {
+            fn(rule.name, rule.removed);
+        }
+    }
+};
+
+/**
+ * @brief 清理规则注册表, 新的泄漏修复只需要注册规则, 不需要再增加一次对 level 数据的遍历
+ */
+class CleanupRegistry {
+    std::vector<std::unique_ptr<CleanupContainerBase>> containers;
+
+public:
+    /**
+     * @brief 获取或创建一个容器, 同名容器的规则会合并到同一次遍历中
+     */
+    template <typename Owner, typename Element>
+    CleanupContainer<Owner, Element> &container(const char *name,
+                                                typename CleanupContainer<Owner, Element>::Reach reach)
+    {
+        for (auto &c : containers) {
+            if (std::strcmp(c->name(), name) == 0) {
+                return static_cast<CleanupContainer<Owner, Element> &>(*c);
+            }
+        }
+        containers.push_back(std::make_unique<CleanupContainer<Owner, Element>>(name, reach));
+        return static_cast<CleanupContainer<Owner, Element> &>(*containers.back());
+    }
+
+    SweepResult run(const CleanupContext &ctx)
+    {
+        SweepResult total;
+        for (auto &c : containers) {
+            auto result = c->run(ctx);
+            total.sweeps += result.sweeps;
+            total.maps += result.maps;
+            total.trackers += result.trackers;
+            total.removed += result.removed;
+        }
+        return total;
+    }
+
+    /**
+     * @brief 每行一条规则及其累计移除数
+     */
+    std::vector<std::string> report() const
+    {
+        std::vector<std::string> lines;
+        for (auto &c : containers) {
+            c->forEachRule([&](const char *rule, uint64_t removed) {
+                lines.push_back(std::string(c->name()) + " / " + rule + ": " + std::to_string(removed));
+            });
+        }
+        return lines;
+    }
+};
+
+using TrackerContainer = CleanupContainer<MapItemSavedData, std::shared_ptr<MapItemTrackedActor>>;
+
+/**
+ * @brief 所有已加载地图的 MapItemTrackedActor 列表
+ */
+inline TrackerContainer &mapTrackers(CleanupRegistry &registry)
+{
+    return registry.container<MapItemSavedData, std::shared_ptr<MapItemTrackedActor>>(
+        "MapItemSavedData::mTrackedEntities", [](const CleanupContext &ctx, const TrackerContainer::Visitor &visitor) {
+            if (!ctx.mapData) {
+                return;
+            }
+            for (auto &[id, data] : MapLayout::allMapData(ctx.mapData)) {
+                visitor(data.get(), MapLayout::trackers(data.get()));
+            }
+        });
+}
+
+/**
+ * @brief 注册内置规则: 移除跟踪已离开 / 已移除的实体和方块实体的 MapItemTrackedActor
+ */
+inline void registerBuiltinRules(CleanupRegistry &registry)
+{
+    auto &trackers = mapTrackers(registry);
+    trackers.addRule("trackedActor", [](const std::shared_ptr<MapItemTrackedActor> &tracker, const MapItemSavedData *,
+                                        const CleanupContext &ctx) {
+        return ctx.target == CleanupTarget::Actor && MapLayout::trackedId(tracker.get()) == ctx.uniqueId;
+    });
+    trackers.addRule("trackedActorOtherDimension", [](const std::shared_ptr<MapItemTrackedActor> &tracker,
+                                                      const MapItemSavedData *data, const CleanupContext &ctx) {
+        return ctx.target == CleanupTarget::ActorDimension && MapLayout::trackedId(tracker.get()) == ctx.uniqueId
+            && MapLayout::dimension(data) != ctx.dimension;
+    });
+    trackers.addRule("trackedBlock", [](const std::shared_ptr<MapItemTrackedActor> &tracker,
+                                        const MapItemSavedData *data, const CleanupContext &ctx) {
+        // 其他维度同一坐标上的展示框不受影响
+        return ctx.target == CleanupTarget::Block
+            && MapLayout::trackedType(tracker.get()) == TrackedType::BlockEntity
+            && MapLayout::trackedBlockPos(tracker.get()) == ctx.blockPos
+            && MapLayout::dimension(data) == ctx.dimension;
+    });
+}
@@ -0,0 +1,338 @@
+#pragma once
+#include "UpdateThrottle.h"
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief 插件配置, 保存在插件数据目录下的 config.json
+ * 缺失或类型不对的字段保留默认值, 加载后会把完整配置写回文件
+ */
+struct PluginConfig {
+    /**
+     * @brief 在后台线程查找特征码并安装Hook, 不阻塞插件加载
+     * 开启后Hook会在服务器已经开始 tick 时从其他线程安装, 默认关闭
+     */
+    bool asyncResolve = false;
+    /**
+     * @brief 查找特征码的时间限制(毫秒), 超过后不再安装剩余的可选Hook
+     * _onPlayerLeft 的修复只要三个特征码都找到就总会安装; 只在两次查找之间检查, 不会中断正在进行的扫描
+     */
+    int resolveTimeoutMs = 30000;
+    /**
+     * @brief 额外的特征码, 键为 Signatures.h 中的函数名, 会在内置特征码之后依次尝试
+     * 没有内置特征码的可选Hook必须在这里提供才会启用
+     */
+    std::map<std::string, std::vector<std::string>> signatures;
+    /**
+     * @brief 查找特征码前先为代码段建立 n-gram 索引, 特征码较多或缓存未命中时可缩短启动时间
+     * 索引约占代码段同等大小的内存, 解析完后立即释放
+     */
+    bool sigIndex = false;
+
+    /**
+     * @brief 用布隆过滤器记录地图跟踪者, 玩家确定没有跟踪者时跳过遍历
+     * 需要 MapItemSavedData::addTrackedMapEntity 的特征码
+     */
+    bool bloomFilter = true;
+    int bloomBits = 1 << 16;
+    int bloomHashes = 4;
+    /**
+     * @brief 定期从地图数据重建过滤器的间隔(秒)
+     */
+    int bloomRebuildSeconds = 300;
+    /**
+     * @brief 估算误判率超过此值时提前重建
+     */
+    double bloomMaxFalsePositiveRate = 0.01;
+
+    /**
+     * @brief 玩家离开后等待多少秒再清理其跟踪者, 期间重新加入则不清理, 0 表示在离开后的下一个 tick 清理
+     */
+    int reconnectGraceSeconds = 0;
+    /**
+     * @brief 被移除的跟踪者何时释放: immediate 清理时直接释放, tick 攒到本 tick 的定时任务中统一释放
+     * 都在服务器线程释放; 旧配置中的 thread 按 tick 处理
+     */
+    std::string reclaimMode = "immediate";
+    /**
+     * @brief 抽样核对的清理比例 (0 ~ 1): 被抽中的清理在优化路径之后再全量遍历一次, 报告并移除被遗漏的跟踪者
+     * 用于在正式服上确认布隆过滤器等优化没有漏掉跟踪者, 0 表示关闭
+     */
+    double shadowSampleRate = 0;
+
+    /**
+     * @brief 录制玩家进出和地图跟踪事件, 供 tools/TraceReplay 回放
+     */
+    bool traceRecord = false;
+    /**
+     * @brief 录制文件名, 相对插件数据目录
+     */
+    std::string traceFile = "trace.log";
+
+    /**
+     * @brief 统计每个 tick 的耗时和其中清理的耗时, 清理导致 tick 超时时输出警告
+     */
+    bool tickMonitor = true;
+    double tickBudgetMs = 50;
+
+    /**
+     * @brief 实体被移除 (死亡, 消失) 时清理跟踪它的地图跟踪者
+     * 需要 Actor::remove 的特征码和 actorUniqueIdOffset
+     * 且只在布隆过滤器启用后生效, 避免每个实体移除都遍历所有地图
+     * 布隆过滤器又需要 MapItemSavedData::addTrackedMapEntity 的特征码, 这些都没有内置值, 所以默认不会运行
+     */
+    bool cleanupOnActorRemove = true;
+    /**
+     * @brief Actor 中 ActorUniqueID 字段的偏移, 直接读取而不调用 getOrCreateUniqueID, 不会为没有 ID 的实体分配 ID
+     */
+    int actorUniqueIdOffset = -1;
+    /**
+     * @brief BlockActor 中方块坐标的偏移, 小于 0 时不处理物品展示框被破坏
+     * 还需要 ItemFrameBlockActor::onRemoved 的特征码, 以及下面三个偏移和 mapDimensionOffset,
+     * 用于只移除展示框所在维度的地图上的跟踪者
+     */
+    int blockActorPositionOffset = -1;
+    /**
+     * @brief BlockSource 中 Level 指针和 Dimension 指针的偏移, Dimension 中 DimensionType 的偏移
+     */
+    int blockSourceLevelOffset = -1;
+    int blockSourceDimensionOffset = -1;
+    int dimensionIdOffset = -1;
+
+    /**
+     * @brief 玩家切换维度时移除其在其他维度地图上的跟踪者
+     * 维度变化由 tick 任务通过插件 API 每秒检查一次, 只需要 MapItemSavedData 中维度字段的偏移
+     */
+    bool cleanupOnDimensionChange = true;
+    int mapDimensionOffset = -1;
+
+    /**
+     * @brief 按玩家与地图的距离降低玩家收到地图更新的频率
+     * 需要 MapItemSavedData::getUpdatePacket 的特征码以及 MapItemSavedData 中中心坐标和缩放比例的偏移
+     */
+    bool trackerThrottle = false;
+    int mapOriginOffset = -1;
+    int mapScaleOffset = -1;
+    /**
+     * @brief 玩家在地图范围外至少 distance 格时每 interval 个 tick 更新一次, 未达到任何一档时每 tick 更新
+     */
+    std::vector<ThrottleTier> throttleTiers = {{128, 2}, {512, 5}, {2048, 20}};
+    /**
+     * @brief 玩家主手拿着地图时的更新间隔, 不受距离影响
+     */
+    int throttleHandInterval = 1;
+
+    /**
+     * @brief 每张地图跟踪者数的软上限, 超出时移除最久没有更新的跟踪者, 0 表示不限制
+     * 只移除已离线或背包中没有地图的玩家的跟踪者, 持有地图的在线玩家和物品展示框较多时会一直超出
+     * 需要 MapItemSavedData::addTrackedMapEntity 和 MapItemTrackedActor::nextUpdatePacket 的特征码
+     */
+    int softMaxTrackersPerMap = 0;
+
+    /**
+     * @brief MapItemSavedData 中像素缓冲区的偏移, 只用于地图快照估算内存, 小于 0 时按默认大小估算
+     */
+    int mapPixelsOffset = -1;
+
+    /**
+     * @brief 每隔多少秒把地图数据写一次快照到 snapshotDir, 0 表示只在执行 /chunkleakfix snapshot 时写
+     */
+    int snapshotIntervalSeconds = 0;
+    /**
+     * @brief 快照每个 tick 最多占用的时间(微秒), 剩下的地图留到下一个 tick
+     */
+    int snapshotBudgetUs = 500;
+    /**
+     * @brief 快照目录, 相对插件数据目录
+     */
+    std::string snapshotDir = "snapshots";
+};
+
+/**
+ * @brief 从 json 中读取一个字段, 字段不存在或类型不匹配时保持原值 (不抛异常)
+ */
+template <typename T>
+inline void readField(const nlohmann::json &j, const char *key, T &out)
+{
+    auto it = j.find(key);
+    if (it == j.end()) {
+        return;
+    }
+    if constexpr (std::is_same_v<T, bool>) {
+        if (it->is_boolean()) {
+            out = it->template get<bool>();
+        }
+    }
+    else if constexpr (std::is_integral_v<T>) {
+        if (it->is_number_integer()) {
+            out = it->template get<T>();
+        }
+    }
+    else if constexpr (std::is_floating_point_v<T>) {
+        if (it->is_number()) {
+            out = it->template get<T>();
+        }
+    }
+    else if constexpr (std::is_same_v<T, std::string>) {
+        if (it->is_string()) {
+            out = it->template get<std::string>();
+        }
+    }
+    else if constexpr (std::is_same_v<T, std::map<std::string, std::vector<std::string>>>) {
+        if (!it->is_object()) {
+            return;
+        }
+        // 每个键可以是单个特征码字符串, 也可以是字符串数组
+        for (auto &[name, value] : it->items()) {
+            auto &patterns = out[name];
+            if (value.is_string()) {
+                patterns.push_back(value.template get<std::string>());
+                continue;
+            }
+            if (!value.is_array()) {
+                continue;
+            }
+            for (auto &pattern : value) {
+                if (pattern.is_string()) {
+                    patterns.push_back(pattern.template get<std::string>());
+                }
+            }
+        }
+    }
+    else if constexpr (std::is_same_v<T, std::vector<ThrottleTier>>) {
+        if (!it->is_array()) {
+            return;
+        }
+        // 数组中的每一档为 {"distance": 格数, "interval": tick 数}
+        out.clear();
+        for (auto &tier : *it) {
+            ThrottleTier value{0, 1};
+            readField(tier, "distance", value.distance);
+            readField(tier, "interval", value.interval);
+            out.push_back(value);
+        }
+    }
+}
+
+inline nlohmann::json throttleTiersToJson(const std::vector<ThrottleTier> &tiers)
+{
+    auto array = nlohmann::json::array();
+    for (auto &tier : tiers) {
+        array.push_back({{"distance", tier.distance}, {"interval", tier.interval}});
+    }
+    return array;
+}
+
+inline nlohmann::json configToJson(const PluginConfig &config)
+{
+    return {
+        {"asyncResolve", config.asyncResolve},
+        {"resolveTimeoutMs", config.resolveTimeoutMs},
+        {"signatures", config.signatures},
+        {"sigIndex", config.sigIndex},
+        {"bloomFilter", config.bloomFilter},
+        {"bloomBits", config.bloomBits},
+        {"bloomHashes", config.bloomHashes},
+        {"bloomRebuildSeconds", config.bloomRebuildSeconds},
+        {"bloomMaxFalsePositiveRate", config.bloomMaxFalsePositiveRate},
+        {"reconnectGraceSeconds", config.reconnectGraceSeconds},
+        {"reclaimMode", config.reclaimMode},
+        {"shadowSampleRate", config.shadowSampleRate},
+        {"traceRecord", config.traceRecord},
+        {"traceFile", config.traceFile},
+        {"tickMonitor", config.tickMonitor},
+        {"tickBudgetMs", config.tickBudgetMs},
+        {"cleanupOnActorRemove", config.cleanupOnActorRemove},
+        {"actorUniqueIdOffset", config.actorUniqueIdOffset},
+        {"blockActorPositionOffset", config.blockActorPositionOffset},
+        {"blockSourceLevelOffset", config.blockSourceLevelOffset},
+        {"blockSourceDimensionOffset", config.blockSourceDimensionOffset},
+        {"dimensionIdOffset", config.dimensionIdOffset},
+        {"cleanupOnDimensionChange", config.cleanupOnDimensionChange},
+        {"mapDimensionOffset", config.mapDimensionOffset},
+        {"trackerThrottle", config.trackerThrottle},
+        {"mapOriginOffset", config.mapOriginOffset},
+        {"mapScaleOffset", config.mapScaleOffset},
+        {"throttleTiers", throttleTiersToJson(config.throttleTiers)},
+        {"throttleHandInterval", config.throttleHandInterval},
+        {"softMaxTrackersPerMap", config.softMaxTrackersPerMap},
+        {"mapPixelsOffset", config.mapPixelsOffset},
+        {"snapshotIntervalSeconds", config.snapshotIntervalSeconds},
+        {"snapshotBudgetUs", config.snapshotBudgetUs},
+        {"snapshotDir", config.snapshotDir},
+    };
+}
+
+inline PluginConfig configFromJson(const nlohmann::json &j)
+{
+    PluginConfig config;
+    if (!j.is_object()) {
+        return config;
+    }
+    readField(j, "asyncResolve", config.asyncResolve);
+    readField(j, "resolveTimeoutMs", config.resolveTimeoutMs);
+    readField(j, "signatures", config.signatures);
+    readField(j, "sigIndex", config.sigIndex);
+    readField(j, "bloomFilter", config.bloomFilter);
+    readField(j, "bloomBits", config.bloomBits);
+    readField(j, "bloomHashes", config.bloomHashes);
+    readField(j, "bloomRebuildSeconds", config.bloomRebuildSeconds);
+    readField(j, "bloomMaxFalsePositiveRate", config.bloomMaxFalsePositiveRate);
+    readField(j, "reconnectGraceSeconds", config.reconnectGraceSeconds);
+    readField(j, "reclaimMode", config.reclaimMode);
+    readField(j, "shadowSampleRate", config.shadowSampleRate);
+    readField(j, "traceRecord", config.traceRecord);
+    readField(j, "traceFile", config.traceFile);
+    readField(j, "tickMonitor", config.tickMonitor);
+    readField(j, "tickBudgetMs", config.tickBudgetMs);
+    readField(j, "cleanupOnActorRemove", config.cleanupOnActorRemove);
+    readField(j, "actorUniqueIdOffset", config.actorUniqueIdOffset);
+    readField(j, "blockActorPositionOffset", config.blockActorPositionOffset);
+    readField(j, "blockSourceLevelOffset", config.blockSourceLevelOffset);
+    readField(j, "blockSourceDimensionOffset", config.blockSourceDimensionOffset);
+    readField(j, "dimensionIdOffset", config.dimensionIdOffset);
+    readField(j, "cleanupOnDimensionChange", config.cleanupOnDimensionChange);
+    readField(j, "mapDimensionOffset", config.mapDimensionOffset);
+    readField(j, "trackerThrottle", config.trackerThrottle);
+    readField(j, "mapOriginOffset", config.mapOriginOffset);
+    readField(j, "mapScaleOffset", config.mapScaleOffset);
+    readField(j, "throttleTiers", config.throttleTiers);
+    readField(j, "throttleHandInterval", config.throttleHandInterval);
+    readField(j, "softMaxTrackersPerMap", config.softMaxTrackersPerMap);
+    readField(j, "mapPixelsOffset", config.mapPixelsOffset);
+    readField(j, "snapshotIntervalSeconds", config.snapshotIntervalSeconds);
+    readField(j, "snapshotBudgetUs", config.snapshotBudgetUs);
+    readField(j, "snapshotDir", config.snapshotDir);
+    return config;
+}
+
+/**
+ * @brief 读取配置文件, 文件不存在或格式错误时使用默认配置
+ * @param path config.json 的路径
+ */
+inline PluginConfig loadConfig(const std::filesystem::path &path)
+{
+    PluginConfig config;
+    std::error_code ec;
+    if (std::filesystem::exists(path, ec)) {
+        std::ifstream in(path);
+        auto j = nlohmann::json::parse(in, nullptr, false);
+        if (j.is_discarded()) {
+            // 格式错误时不覆盖用户的文件
+            return config;
+        }
+        config = configFromJson(j);
+    }
+    std::filesystem::create_directories(path.parent_path(), ec);
+    std::ofstream out(path);
+    if (out) {
+        out << configToJson(config).dump(4);
+    }
+    return config;
+}
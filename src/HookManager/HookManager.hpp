@@ -7,6 +7,7 @@
 #define HOOKMANAGER_HPP
 
 // 定义 USE_LIGHTHOOK 宏或定义 USE_MINHOOK, 来表示使用何种Hook实现底层逻辑
+// Linux 下定义 USE_LINUXHOOK, 使用自带的 LinuxHook.hpp (接口与 LightHook 相同)
 // 如果定义 EXTERNAL_INCLUDE_HOOKHEADER 宏，则表示引用底层Hook的头文件由外部实现
 
 #ifdef USE_LIGHTHOOK
@@ -28,33 +29,62 @@
 #include <MinHook.h>
 #endif // EXTERNAL_INCLUDE_HOOKHEADER
 
+#elif defined USE_LINUXHOOK
+#include "LinuxHook.hpp"
+#include <sys/mman.h>
+
 #else
-#error You Need Define One Hooklib, USE_LIGHTHOOK OR USE_MINHOOK OR USE_DETOURS
+#error You Need Define One Hooklib, USE_LIGHTHOOK OR USE_MINHOOK OR USE_DETOURS OR USE_LINUXHOOK
 #endif // USE_LIGHTHOOK
 
-#if !(defined USE_LIGHTHOOK) && !(defined USE_MINHOOK) && !(defined USE_DETOURS)
-#error You Need Define One Hooklib, USE_LIGHTHOOK OR USE_MINHOOK OR USE_DETOURS
+#if !(defined USE_LIGHTHOOK) && !(defined USE_MINHOOK) && !(defined USE_DETOURS) && !(defined USE_LINUXHOOK)
+#error You Need Define One Hooklib, USE_LIGHTHOOK OR USE_MINHOOK OR USE_DETOURS OR USE_LINUXHOOK
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cstring>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <shared_mutex>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 class HookInstance {
+    friend class HookManager;
+
 private:
     uintptr_t m_ptr = 0;
     uintptr_t m_mapindex = 0;
     std::string m_describe{};
+    void *m_fun = nullptr;
+    int m_priority = 0;
+    bool m_enabled = false;
 
 public:
-    void *origin = nullptr;
+    /**
+     * @brief 调用链中的下一个回调, 最后一个回调指向原函数的跳板
+     * 其他线程可能正在经过分发桩调用回调, 重新连接时以 release 写入, 回调以 acquire 读取
+     */
+    std::atomic<void *> origin{nullptr};
 
 public:
     HookInstance() {};
     HookInstance(uintptr_t ptr) : m_ptr(ptr), m_mapindex(ptr) {};
     HookInstance(uintptr_t ptr, std::string describe) : m_ptr(ptr), m_mapindex(ptr), m_describe(describe) {};
+    HookInstance(uintptr_t ptr, std::string describe, void *fun, int priority)
+        : m_ptr(ptr), m_mapindex(ptr), m_describe(describe), m_fun(fun), m_priority(priority) {};
+    /**
+     * @brief 只在放入对象池之前使用 (std::vector 要求元素可移动), 此时还没有其他线程能访问它
+     */
+    HookInstance(HookInstance &&other) noexcept
+        : m_ptr(other.m_ptr), m_mapindex(other.m_mapindex), m_describe(std::move(other.m_describe)),
+          m_fun(other.m_fun), m_priority(other.m_priority), m_enabled(other.m_enabled),
+          origin(other.origin.load(std::memory_order_relaxed)) {};
     uintptr_t &ptr();
     uintptr_t ptr() const;
     uintptr_t mapindex() const
@@ -62,30 +92,125 @@ public:
         return m_mapindex;
     };
     std::string describe() const;
+    void *fun() const
+    {
+        return m_fun;
+    };
+    int priority() const
+    {
+        return m_priority;
+    };
+    bool enabled() const
+    {
+        return m_enabled;
+    };
     bool hook();
     bool unhook();
 
     template <typename T>
     T oriForSign(T)
     {
-        return static_cast<T>(origin);
+        return reinterpret_cast<T>(origin.load(std::memory_order_acquire));
     }
 };
 
-class HookManager {
+/**
+ * @brief 只增不减的对象池: 按块分配, 块满后再分配新块, 已有元素不会移动, 指针在池的整个生命周期内有效
+ * 同一块中的元素连续存放, 按添加顺序遍历
+ */
+template <typename T, size_t ChunkSize = 16>
+class HookArena {
 private:
-    std::shared_mutex map_lock_mutex;
-#ifdef USE_LIGHTHOOK
-    std::unordered_map<uintptr_t, std::pair<HookInformation, HookInstance>> hookInfoHash{};
-#endif
+    std::vector<std::vector<T>> m_chunks;
+    size_t m_size = 0;
 
-#ifdef USE_MINHOOK
-    std::unordered_map<uintptr_t, std::pair<uintptr_t, HookInstance>> hookInfoHash{};
-#endif // USE_MINHOOK
+public:
+    template <typename... Args>
+    T *emplace(Args &&...args)
+    {
+        if (m_chunks.empty() || m_chunks.back().size() == ChunkSize) {
+            // 预留整块容量, 之后的 emplace_back 不会重新分配, 已有元素的地址保持不变
+            m_chunks.emplace_back().reserve(ChunkSize);
+        }
+        m_size++;
+        return &m_chunks.back().emplace_back(std::forward<Args>(args)...);
+    }
+
+    template <typename Fn>
+    void forEach(Fn &&fn)
+    {
+        for (auto &chunk : m_chunks) {
+            for (auto &item : chunk) {
+                fn(item);
+            }
+        }
+    }
+
+    size_t size() const
+    {
+        return m_size;
+    }
+};
+
+/**
+ * @brief 分发桩: 底层Hook固定跳到这里, 再间接跳到调用链的第一个回调
+ * 调用链变化时只需原子地改写跳转地址, 不需要重新挂钩
+ */
+class HookDispatchStub {
+private:
+    // 布局: [8 字节跳转地址] [FF 25 F2 FF FF FF] jmp qword ptr [rip-14]
+    static constexpr size_t stubSize = 16;
+    static constexpr size_t pageSize = 4096;
+    uint8_t *m_stub = nullptr;
+
+public:
+    /**
+     * @brief 从可执行内存页中分配一个分发桩, 分发桩不会被释放
+     */
+    bool create();
+    void *entry() const
+    {
+        return m_stub + 8;
+    };
+    void retarget(void *fun);
+};
 
+class HookManager {
+private:
+    /**
+     * @brief 同一目标地址上的所有Hook, 共用一个底层Hook和分发桩
+     */
+    struct HookTarget {
+        uintptr_t ptr = 0;
+#if defined USE_LIGHTHOOK || defined USE_LINUXHOOK
+        HookInformation info{};
+#endif // USE_LIGHTHOOK
 #ifdef USE_DETOURS
-    std::unordered_map<uintptr_t, std::pair<uintptr_t, HookInstance>> hookInfoHash{};
-#endif // USE_MINHOOK
+        /**
+         * @brief Detours 挂钩时会把它改写为跳板地址, 卸载时再改回来
+         */
+        void *pointer = nullptr;
+#endif // USE_DETOURS
+        /**
+         * @brief 调用原函数的跳板, 必须在底层Hook生效之前就已填好, 链尾回调的 origin 始终指向它
+         */
+        void *trampoline = nullptr;
+        bool enabled = false;
+        HookDispatchStub stub;
+        /**
+         * @brief 按优先级从高到低排列, 优先级相同时先添加的在前, 指向 instances 中的元素
+         */
+        std::vector<HookInstance *> chain;
+    };
+
+    std::shared_mutex map_lock_mutex;
+    /**
+     * @brief 目标和Hook实例都放在对象池中, 返回给调用者的指针不会因为注册表增长而失效
+     * enableAllHook / disableAllHook 按添加顺序遍历连续存放的目标, 哈希表只用于按地址查找
+     */
+    HookArena<HookTarget> targets;
+    HookArena<HookInstance> instances;
+    std::unordered_map<uintptr_t, HookTarget *> hookInfoHash{};
 
 public:
     enum msgtype {
@@ -103,14 +228,17 @@ public:
 
 public:
     /**
-     * @brief 添加一个Hook
+     * @brief 添加一个Hook, 同一个目标地址可以添加多个Hook
+     * 目标被调用时按优先级从高到低依次进入各个回调, 每个回调通过 origin 调用下一个, 最后一个调用原函数
      * @param ptr hook的目标地址
      * @param fun hook拦截后要执行的本地函数
      * @param hook_describe 关于这个hook的描述 (可留空)
+     * @param priority 优先级, 越大越先执行, 相同时先添加的先执行
      * @return 返回针对这个hook的控制器(单例，单个hook管理器)
      */
     auto addHook(uintptr_t ptr, void *fun) -> HookInstance *;
     auto addHook(uintptr_t ptr, void *fun, std::string hook_describe) -> HookInstance *;
+    auto addHook(uintptr_t ptr, void *fun, std::string hook_describe, int priority) -> HookInstance *;
 
     /**
      * @brief 开启一个hook
@@ -118,7 +246,7 @@ public:
      */
     auto enableHook(HookInstance &) -> bool;
     /**
-     * @brief 关闭一个hook
+     * @brief 关闭一个hook, 同一目标上的其他hook不受影响
      * @return 是否成功
      */
     auto disableHook(HookInstance &) -> bool;
@@ -133,7 +261,7 @@ public:
      */
     auto disableAllHook() -> void;
     /**
-     * @brief 通过hook的目标函数地址找到对应的hook单例(这个函数后续可能有冲突,暂且保留)
+     * @brief 通过hook的目标函数地址找到对应的hook单例, 有多个时返回优先级最高的
      * @param  hook的目标函数地址
      * @return 返回找到的hook单例
      */
@@ -152,6 +280,17 @@ public:
 private:
     auto on(msgtype type, std::string msg) -> void;
 
+    /**
+     * @brief 按调用链顺序重新连接各个开启的回调, 并让分发桩指向第一个
+     */
+    auto relink(HookTarget &target) -> void;
+    /**
+     * @brief 安装/卸载目标地址上的底层Hook
+     */
+    auto nativeEnable(HookTarget &target) -> bool;
+    auto nativeDisable(HookTarget &target) -> bool;
+    static auto describe(const HookTarget &target) -> const char *;
+
 private:
     HookManager();
     ~HookManager();
@@ -168,6 +307,35 @@ static std::string str_fmt(const char *fmt, ...);
 
 ////////////////////////////////////////////////
 
+inline bool HookDispatchStub::create()
+{
+    static uint8_t *page = nullptr;
+    static size_t used = pageSize;
+    if (used + stubSize > pageSize) {
+#ifdef USE_LINUXHOOK
+        void *p = mmap(nullptr, pageSize, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        page = p == MAP_FAILED ? nullptr : (uint8_t *)p;
+#else
+        page = (uint8_t *)VirtualAlloc(nullptr, pageSize, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+#endif // USE_LINUXHOOK
+        if (!page) {
+            return false;
+        }
+        used = 0;
+    }
+    m_stub = page + used;
+    used += stubSize;
+    static constexpr uint8_t jmp[] = {0xFF, 0x25, 0xF2, 0xFF, 0xFF, 0xFF};
+    std::memset(m_stub, 0, 8);
+    std::memcpy(m_stub + 8, jmp, sizeof(jmp));
+    return true;
+}
+
+inline void HookDispatchStub::retarget(void *fun)
+{
+    std::atomic_ref<void *>(*reinterpret_cast<void **>(m_stub)).store(fun, std::memory_order_release);
+}
+
 inline HookManager *HookManager::getInstance()
 {
     static HookManager hookManager{};
@@ -219,31 +387,35 @@ inline auto HookManager::addHook(uintptr_t ptr, void *fun) -> HookInstance *
 
 inline auto HookManager::addHook(uintptr_t ptr, void *fun, std::string hook_describe) -> HookInstance *
 {
-    std::shared_lock<std::shared_mutex> guard(map_lock_mutex);
+    return addHook(ptr, fun, hook_describe, 0);
+}
+
+inline auto HookManager::addHook(uintptr_t ptr, void *fun, std::string hook_describe, int priority) -> HookInstance *
+{
+    std::unique_lock<std::shared_mutex> guard(map_lock_mutex);
     auto it = hookInfoHash.find(ptr);
-    if (it != hookInfoHash.end()) {
-        // TODO:
-        // spdlog::warn("addHook 新增Hook失败,当前函数已被hook({}) - fromFunction {} - in {}", (const void*)ptr,
-        // __FUNCTION__, __LINE__);
-        if ((*it).second.second.describe().empty()) {
-            on(msgtype::debug, str_fmt("暂不支持重复Hook, addHook 新增Hook失败, hook指针:[%p]", ptr));
+    if (it == hookInfoHash.end()) {
+        HookTarget target;
+        target.ptr = ptr;
+        if (!target.stub.create()) {
+            on(msgtype::error, str_fmt("分配分发桩失败, addHook 新增Hook失败, hook指针:[%p]，文件:[%s] 函数: [%s] 行:[%d]",
+                                       ptr, __FILE__, __FUNCTION__, __LINE__));
+            return nullptr;
         }
-        else {
-            on(msgtype::debug, str_fmt("暂不支持重复Hook, addHook 新增Hook失败, hook指针:[%p],已存在的Hook目标: [%s]",
-                                       ptr, (*it).second.second.describe().c_str()));
+#if defined USE_LIGHTHOOK || defined USE_LINUXHOOK
+        target.info = CreateHook((void *)ptr, target.stub.entry());
+        if (!target.info.Trampoline) {
+            on(msgtype::error, str_fmt("CreateHook 创建跳板失败，目标Hook描述信息:[%s],文件:[%s] 函数: [%s] 行:[%d]",
+                                       hook_describe.empty() ? "无" : hook_describe.c_str(), __FILE__, __FUNCTION__,
+                                       __LINE__));
+            return nullptr;
         }
-        return nullptr;
-    }
-    else {
-#ifdef USE_LIGHTHOOK
-        hookInfoHash[ptr] = {CreateHook((void *)ptr, fun),
-                             hook_describe.empty() ? HookInstance(ptr) : HookInstance(ptr, hook_describe)};
+        // CreateHook 已经生成跳板, EnableHook 只写入跳转指令
+        target.trampoline = target.info.Trampoline;
 #endif // USE_LIGHTHOOK
 
 #ifdef USE_MINHOOK
-        hookInfoHash[ptr] = {ptr, hook_describe.empty() ? HookInstance(ptr) : HookInstance(ptr, hook_describe)};
-        MH_STATUS status =
-            MH_CreateHook((LPVOID)ptr, (LPVOID)fun, reinterpret_cast<LPVOID *>(&hookInfoHash[ptr].second.origin));
+        MH_STATUS status = MH_CreateHook((LPVOID)ptr, (LPVOID)target.stub.entry(), &target.trampoline);
         if (status != MH_OK) {
             on(msgtype::error,
                str_fmt("MH_CreateHook 返回标识失败:[%s]，目标Hook描述信息:[%s],文件:[%s] 函数: [%s] 行:[%d]",
@@ -251,39 +423,155 @@ inline auto HookManager::addHook(uintptr_t ptr, void *fun, std::string hook_desc
                        __FUNCTION__, __LINE__));
             return nullptr;
         }
-
 #endif // USE_MINHOOK
 
 #ifdef USE_DETOURS
-        hookInfoHash[ptr] = {(uintptr_t)fun,
-                             hook_describe.empty() ? HookInstance(ptr) : HookInstance(ptr, hook_describe)};
+        target.pointer = (void *)ptr;
 #endif // USE_DETOURS
-        return &hookInfoHash[ptr].second;
+        it = hookInfoHash.emplace(ptr, targets.emplace(std::move(target))).first;
+    }
+
+    auto &chain = it->second->chain;
+    for (auto &instance : chain) {
+        if (instance->fun() == fun) {
+            on(msgtype::debug, str_fmt("同一个回调不能重复Hook同一地址, addHook 新增Hook失败, hook指针:[%p],已存在的Hook目标: [%s]",
+                                       ptr, instance->describe().empty() ? "无" : instance->describe().c_str()));
+            return nullptr;
+        }
     }
+    auto pos =
+        std::find_if(chain.begin(), chain.end(), [priority](const HookInstance *i) { return i->priority() < priority; });
+    return *chain.insert(pos, instances.emplace(ptr, std::move(hook_describe), fun, priority));
 }
 
 inline auto HookManager::enableHook(HookInstance &instance) -> bool
+{
+    std::unique_lock<std::shared_mutex> guard(map_lock_mutex);
+    auto it = hookInfoHash.find(instance.mapindex());
+    if (it == hookInfoHash.end()) {
+        return false;
+    }
+    auto &target = *it->second;
+    instance.m_enabled = true;
+    // 先连好调用链再安装底层Hook, 目标一被改写, 进入的回调就能通过 origin 调到原函数
+    relink(target);
+    if (!target.enabled && !nativeEnable(target)) {
+        instance.m_enabled = false;
+        relink(target);
+        return false;
+    }
+    return true;
+}
+
+inline auto HookManager::disableHook(HookInstance &instance) -> bool
+{
+    std::unique_lock<std::shared_mutex> guard(map_lock_mutex);
+    auto it = hookInfoHash.find(instance.mapindex());
+    if (it == hookInfoHash.end()) {
+        return false;
+    }
+    auto &target = *it->second;
+    instance.m_enabled = false;
+    relink(target);
+    bool anyEnabled =
+        std::any_of(target.chain.begin(), target.chain.end(), [](const HookInstance *i) { return i->enabled(); });
+    if (target.enabled && !anyEnabled) {
+        return nativeDisable(target);
+    }
+    return true;
+}
+
+inline auto HookManager::enableAllHook() -> void
+{
+    std::unique_lock<std::shared_mutex> guard(map_lock_mutex);
+    instances.forEach([](HookInstance &instance) { instance.m_enabled = true; });
+    targets.forEach([this](HookTarget &target) {
+        relink(target);
+        if (!target.enabled) {
+            nativeEnable(target);
+        }
+    });
+}
+
+inline auto HookManager::disableAllHook() -> void
+{
+    std::unique_lock<std::shared_mutex> guard(map_lock_mutex);
+    instances.forEach([](HookInstance &instance) { instance.m_enabled = false; });
+    targets.forEach([this](HookTarget &target) {
+        relink(target);
+        if (target.enabled) {
+            nativeDisable(target);
+        }
+    });
+}
+
+inline auto HookManager::findHookInstance(uintptr_t indexptr) -> HookInstance *
 {
     std::shared_lock<std::shared_mutex> guard(map_lock_mutex);
-#ifdef USE_LIGHTHOOK
-    int ret = EnableHook(&hookInfoHash[instance.mapindex()].first);
+    auto it = hookInfoHash.find(indexptr);
+    if (it != hookInfoHash.end() && !it->second->chain.empty()) {
+        return it->second->chain.front();
+    }
+    return nullptr;
+}
+
+inline auto HookManager::on(MessageEvent ev) -> void
+{
+    event = ev;
+}
+
+inline auto HookManager::on(msgtype type, std::string msg) -> void
+{
+    if (event) {
+        event(type, msg);
+    }
+}
+
+inline auto HookManager::relink(HookTarget &target) -> void
+{
+    // 从链尾往前连接: 先写好自己的后继再让前驱指向自己, 正在执行的调用始终走在一条完整的链上
+    void *next = target.trampoline;
+    for (auto it = target.chain.rbegin(); it != target.chain.rend(); ++it) {
+        if ((*it)->m_enabled) {
+            (*it)->origin.store(next, std::memory_order_release);
+            next = (*it)->m_fun;
+        }
+    }
+    // 没有开启的回调时直接跳回原函数
+    target.stub.retarget(next);
+}
+
+inline auto HookManager::describe(const HookTarget &target) -> const char *
+{
+    for (auto &instance : target.chain) {
+        if (!instance->m_describe.empty()) {
+            return instance->m_describe.c_str();
+        }
+    }
+    return "无";
+}
+
+inline auto HookManager::nativeEnable(HookTarget &target) -> bool
+{
+#if defined USE_LIGHTHOOK || defined USE_LINUXHOOK
+    int ret = EnableHook(&target.info);
     if (ret == 0) {
-        on(msgtype::error,
-           str_fmt("LightHook EnableHook 失败，目标Hook描述信息:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                   instance.describe().empty() ? "无" : instance.describe().c_str(), __FILE__, __FUNCTION__, __LINE__));
+        on(msgtype::error, str_fmt("LightHook EnableHook 失败，目标Hook描述信息:[%s],文件:[%s] 函数: [%s] 行:[%d]",
+                                   describe(target), __FILE__, __FUNCTION__, __LINE__));
+        return false;
     }
-    instance.origin = hookInfoHash[instance.mapindex()].first.Trampoline;
-    return ret;
+    target.enabled = true;
+    return true;
 #endif // USE_LIGHTHOOK
 #ifdef USE_MINHOOK
-    MH_STATUS status = MH_EnableHook((LPVOID)instance.ptr());
+    MH_STATUS status = MH_EnableHook((LPVOID)target.ptr);
     if (status != MH_OK) {
         on(msgtype::error,
            str_fmt("MH_EnableHook 返回标识失败:[%s]，目标Hook描述信息:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                   MH_StatusToString(status), instance.describe().empty() ? "无" : instance.describe().c_str(),
-                   __FILE__, __FUNCTION__, __LINE__));
+                   MH_StatusToString(status), describe(target), __FILE__, __FUNCTION__, __LINE__));
         return false;
     }
+    target.enabled = true;
     return true;
 #endif // USE_MINHOOK
 
@@ -293,8 +581,7 @@ inline auto HookManager::enableHook(HookInstance &instance) -> bool
         if (d_t_b_msg == ERROR_INVALID_OPERATION) {
             on(msgtype::error, str_fmt("Detour一个挂起的事务已经存在，事务还未提交就是重复执行了，目标Hook描述信息:[%s]"
                                        "，流程:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                                       instance.describe().empty() ? "无" : instance.describe().c_str(),
-                                       "DetourTransactionBegin", __FILE__, __FUNCTION__, __LINE__));
+                                       describe(target), "DetourTransactionBegin", __FILE__, __FUNCTION__, __LINE__));
         }
         DetourTransactionAbort();
         return false;
@@ -305,96 +592,91 @@ inline auto HookManager::enableHook(HookInstance &instance) -> bool
         if (d_u_t_msg == ERROR_NOT_ENOUGH_MEMORY) {
             on(msgtype::error, str_fmt("Detour没有足够的内存来记录线程的标识，目标Hook描述信息:[%s]，流程:[%s],文件:[%"
                                        "s] 函数: [%s] 行:[%d]",
-                                       instance.describe().empty() ? "无" : instance.describe().c_str(),
-                                       "DetourUpdateThread", __FILE__, __FUNCTION__, __LINE__));
+                                       describe(target), "DetourUpdateThread", __FILE__, __FUNCTION__, __LINE__));
         }
         DetourTransactionAbort();
         return false;
     }
 
-    LONG d_a_ex = DetourAttachEx((PVOID *)&instance.ptr(), (PVOID)hookInfoHash[instance.mapindex()].first,
-                                 (PDETOUR_TRAMPOLINE *)&instance.origin, 0, 0);
+    PDETOUR_TRAMPOLINE realTrampoline = nullptr;
+    LONG d_a_ex = DetourAttachEx((PVOID *)&target.pointer, (PVOID)target.stub.entry(), &realTrampoline, 0, 0);
     if (d_a_ex != NO_ERROR) {
         if (d_a_ex == ERROR_INVALID_BLOCK) {
             on(msgtype::error,
                str_fmt(
                    "Detour被引用的函数太小，不能Hook，目标Hook描述信息:[%s]，流程:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                   instance.describe().empty() ? "无" : instance.describe().c_str(), "DetourAttachEx", __FILE__,
-                   __FUNCTION__, __LINE__));
+                   describe(target), "DetourAttachEx", __FILE__, __FUNCTION__, __LINE__));
         }
         else if (d_a_ex == ERROR_INVALID_HANDLE) {
             on(msgtype::error,
                str_fmt("Detour 此Hook的目标地址为NULL或指向NULL指针，目标Hook描述信息:[%s]，流程:[%s],文件:[%s] 函数: "
                        "[%s] 行:[%d]",
-                       instance.describe().empty() ? "无" : instance.describe().c_str(), "DetourAttachEx", __FILE__,
-                       __FUNCTION__, __LINE__));
+                       describe(target), "DetourAttachEx", __FILE__, __FUNCTION__, __LINE__));
         }
         else if (d_a_ex == ERROR_INVALID_OPERATION) {
             on(msgtype::error,
                str_fmt("Detour不存在挂起的事务，目标Hook描述信息:[%s]，流程:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                       "DetourAttachEx", instance.describe().empty() ? "无" : instance.describe().c_str(),
-                       "DetourAttachEx", __FILE__, __FUNCTION__, __LINE__));
+                       describe(target), "DetourAttachEx", __FILE__, __FUNCTION__, __LINE__));
         }
         else if (d_a_ex == ERROR_NOT_ENOUGH_MEMORY) {
             on(msgtype::error, str_fmt("Detour没有足够的内存来记录线程的标识，目标Hook描述信息:[%s]，流程:[%s],文件:[%"
                                        "s] 函数: [%s] 行:[%d]",
-                                       instance.describe().empty() ? "无" : instance.describe().c_str(),
-                                       "DetourAttachEx", __FILE__, __FUNCTION__, __LINE__));
+                                       describe(target), "DetourAttachEx", __FILE__, __FUNCTION__, __LINE__));
         }
         DetourTransactionAbort();
         return false;
     }
+    // Detours 在 DetourAttachEx 时生成跳板, 提交事务时才改写目标; 提交前连好调用链
+    target.trampoline = realTrampoline;
+    relink(target);
 
     LONG d_t_c_msg = DetourTransactionCommit();
     if (d_t_c_msg != NO_ERROR) {
         if (d_t_c_msg == ERROR_INVALID_DATA) {
             on(msgtype::error, str_fmt("Detour目标函数在事务的各个步骤之间被第三方更改，目标Hook描述信息:[%s]，流程:[%"
                                        "s],文件:[%s] 函数: [%s] 行:[%d]",
-                                       instance.describe().empty() ? "无" : instance.describe().c_str(),
-                                       "DetourTransactionCommit", __FILE__, __FUNCTION__, __LINE__));
+                                       describe(target), "DetourTransactionCommit", __FILE__, __FUNCTION__, __LINE__));
         }
         else if (d_t_c_msg == ERROR_INVALID_OPERATION) {
             on(msgtype::error,
                str_fmt("Detour不存在挂起的事务，目标Hook描述信息:[%s]，流程:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                       instance.describe().empty() ? "无" : instance.describe().c_str(), "DetourTransactionCommit",
-                       __FILE__, __FUNCTION__, __LINE__));
+                       describe(target), "DetourTransactionCommit", __FILE__, __FUNCTION__, __LINE__));
         }
         else {
             on(msgtype::error,
                str_fmt("Detour DetourTransactionCommit返回未知错误:[%ld]，目标Hook描述信息:[%s]，流程:[%s],文件:[%s] "
                        "函数: [%s] 行:[%d]",
-                       d_t_c_msg, instance.describe().empty() ? "无" : instance.describe().c_str(),
-                       "DetourTransactionCommit", __FILE__, __FUNCTION__, __LINE__));
+                       d_t_c_msg, describe(target), "DetourTransactionCommit", __FILE__, __FUNCTION__, __LINE__));
         }
         DetourTransactionAbort();
         return false;
     }
+    target.enabled = true;
     return true;
-#endif // USE_MINHOOK
+#endif // USE_DETOURS
 }
 
-inline auto HookManager::disableHook(HookInstance &instance) -> bool
+inline auto HookManager::nativeDisable(HookTarget &target) -> bool
 {
-    std::shared_lock<std::shared_mutex> guard(map_lock_mutex);
-
-#ifdef USE_LIGHTHOOK
-    int ret = DisableHook(&hookInfoHash[instance.mapindex()].first);
+#if defined USE_LIGHTHOOK || defined USE_LINUXHOOK
+    int ret = DisableHook(&target.info);
     if (ret == 0) {
-        on(msgtype::error,
-           str_fmt("LightHook DisableHook 失败，目标Hook描述信息:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                   instance.describe().empty() ? "无" : instance.describe().c_str(), __FILE__, __FUNCTION__, __LINE__));
+        on(msgtype::error, str_fmt("LightHook DisableHook 失败，目标Hook描述信息:[%s],文件:[%s] 函数: [%s] 行:[%d]",
+                                   describe(target), __FILE__, __FUNCTION__, __LINE__));
+        return false;
     }
-    return ret;
+    target.enabled = false;
+    return true;
 #endif // USE_LIGHTHOOK
 #ifdef USE_MINHOOK
-    MH_STATUS status = MH_DisableHook((LPVOID)instance.ptr());
+    MH_STATUS status = MH_DisableHook((LPVOID)target.ptr);
     if (status != MH_OK) {
         on(msgtype::error,
            str_fmt("MH_DisableHook 返回标识失败:[%s]，目标Hook描述信息:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                   MH_StatusToString(status), instance.describe().empty() ? "无" : instance.describe().c_str(),
-                   __FILE__, __FUNCTION__, __LINE__));
+                   MH_StatusToString(status), describe(target), __FILE__, __FUNCTION__, __LINE__));
         return false;
     }
+    target.enabled = false;
     return true;
 #endif // USE_MINHOOK
 
@@ -404,8 +686,7 @@ inline auto HookManager::disableHook(HookInstance &instance) -> bool
         if (d_t_b_msg == ERROR_INVALID_OPERATION) {
             on(msgtype::error, str_fmt("Detour一个挂起的事务已经存在，事务还未提交就是重复执行了，目标Hook描述信息:[%s]"
                                        "，流程:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                                       instance.describe().empty() ? "无" : instance.describe().c_str(),
-                                       "DetourTransactionBegin", __FILE__, __FUNCTION__, __LINE__));
+                                       describe(target), "DetourTransactionBegin", __FILE__, __FUNCTION__, __LINE__));
         }
         DetourTransactionAbort();
         return false;
@@ -416,40 +697,35 @@ inline auto HookManager::disableHook(HookInstance &instance) -> bool
         if (d_u_t_msg == ERROR_NOT_ENOUGH_MEMORY) {
             on(msgtype::error, str_fmt("Detour没有足够的内存来记录线程的标识，目标Hook描述信息:[%s]，流程:[%s],文件:[%"
                                        "s] 函数: [%s] 行:[%d]",
-                                       instance.describe().empty() ? "无" : instance.describe().c_str(),
-                                       "DetourUpdateThread", __FILE__, __FUNCTION__, __LINE__));
+                                       describe(target), "DetourUpdateThread", __FILE__, __FUNCTION__, __LINE__));
         }
         DetourTransactionAbort();
         return false;
     }
 
-    LONG d_d_msg = DetourDetach((PVOID *)&instance.ptr(), (PVOID)hookInfoHash[instance.mapindex()].first);
+    LONG d_d_msg = DetourDetach((PVOID *)&target.pointer, (PVOID)target.stub.entry());
     if (d_d_msg != NO_ERROR) {
         if (d_d_msg == ERROR_INVALID_BLOCK) {
             on(msgtype::error,
                str_fmt(
                    "Detour被引用的函数太小，不能Hook，目标Hook描述信息:[%s]，流程:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                   instance.describe().empty() ? "无" : instance.describe().c_str(), "DetourDetach", __FILE__,
-                   __FUNCTION__, __LINE__));
+                   describe(target), "DetourDetach", __FILE__, __FUNCTION__, __LINE__));
         }
         else if (d_d_msg == ERROR_INVALID_HANDLE) {
             on(msgtype::error,
                str_fmt("Detour 此Hook的目标地址为NULL或指向NULL指针，目标Hook描述信息:[%s]，流程:[%s],文件:[%s] 函数: "
                        "[%s] 行:[%d]",
-                       instance.describe().empty() ? "无" : instance.describe().c_str(), "DetourDetach", __FILE__,
-                       __FUNCTION__, __LINE__));
+                       describe(target), "DetourDetach", __FILE__, __FUNCTION__, __LINE__));
         }
         else if (d_d_msg == ERROR_INVALID_OPERATION) {
             on(msgtype::error,
                str_fmt("Detour不存在挂起的事务，目标Hook描述信息:[%s]，流程:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                       instance.describe().empty() ? "无" : instance.describe().c_str(), "DetourDetach", __FILE__,
-                       __FUNCTION__, __LINE__));
+                       describe(target), "DetourDetach", __FILE__, __FUNCTION__, __LINE__));
         }
         else if (d_d_msg == ERROR_NOT_ENOUGH_MEMORY) {
             on(msgtype::error, str_fmt("Detour没有足够的内存来记录线程的标识，目标Hook描述信息:[%s]，流程:[%s],文件:[%"
                                        "s] 函数: [%s] 行:[%d]",
-                                       instance.describe().empty() ? "无" : instance.describe().c_str(), "DetourDetach",
-                                       __FILE__, __FUNCTION__, __LINE__));
+                                       describe(target), "DetourDetach", __FILE__, __FUNCTION__, __LINE__));
         }
         DetourTransactionAbort();
         return false;
@@ -460,281 +736,27 @@ inline auto HookManager::disableHook(HookInstance &instance) -> bool
         if (d_t_c_msg == ERROR_INVALID_DATA) {
             on(msgtype::error, str_fmt("Detour目标函数在事务的各个步骤之间被第三方更改，目标Hook描述信息:[%s]，流程:[%"
                                        "s],文件:[%s] 函数: [%s] 行:[%d]",
-                                       instance.describe().empty() ? "无" : instance.describe().c_str(),
-                                       "DetourTransactionCommit", __FILE__, __FUNCTION__, __LINE__));
+                                       describe(target), "DetourTransactionCommit", __FILE__, __FUNCTION__, __LINE__));
         }
         else if (d_t_c_msg == ERROR_INVALID_OPERATION) {
             on(msgtype::error,
                str_fmt("Detour不存在挂起的事务，目标Hook描述信息:[%s]，流程:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                       instance.describe().empty() ? "无" : instance.describe().c_str(), "DetourTransactionCommit",
-                       __FILE__, __FUNCTION__, __LINE__));
+                       describe(target), "DetourTransactionCommit", __FILE__, __FUNCTION__, __LINE__));
         }
         else {
             on(msgtype::error,
                str_fmt("Detour DetourTransactionCommit返回未知错误:[%ld]，目标Hook描述信息:[%s]，流程:[%s],文件:[%s] "
                        "函数: [%s] 行:[%d]",
-                       d_t_c_msg, instance.describe().empty() ? "无" : instance.describe().c_str(),
-                       "DetourTransactionCommit", __FILE__, __FUNCTION__, __LINE__));
+                       d_t_c_msg, describe(target), "DetourTransactionCommit", __FILE__, __FUNCTION__, __LINE__));
         }
         DetourTransactionAbort();
         return false;
     }
+    target.enabled = false;
     return true;
-#endif // USE_MINHOOK
-}
-
-inline auto HookManager::enableAllHook() -> void
-{
-    std::shared_lock<std::shared_mutex> guard(map_lock_mutex);
-
-#ifdef USE_LIGHTHOOK
-    for (auto &item : hookInfoHash) {
-        if (!item.second.first.Enabled) {
-            if (!EnableHook(&item.second.first)) {
-                on(msgtype::error,
-                   str_fmt("LightHook EnableHook 开启Hook失败，目标Hook描述信息:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                           item.second.second.describe().empty() ? "无" : item.second.second.describe().c_str(),
-                           __FILE__, __FUNCTION__, __LINE__));
-            }
-        }
-    }
-#endif // USE_LIGHTHOOK
-
-#ifdef USE_MINHOOK
-    for (auto &item : hookInfoHash) {
-        MH_STATUS status = MH_EnableHook((LPVOID)item.second.first);
-        if (status != MH_OK) {
-            on(msgtype::error,
-               str_fmt("MH_EnableHook 返回标识失败:[%s]，目标Hook描述信息:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                       MH_StatusToString(status),
-                       item.second.second.describe().empty() ? "无" : item.second.second.describe().c_str(), __FILE__,
-                       __FUNCTION__, __LINE__));
-        }
-    }
-#endif // USE_MINHOOK
-
-#ifdef USE_DETOURS
-    LONG d_t_b_msg = DetourTransactionBegin();
-    if (d_t_b_msg != NO_ERROR) {
-        if (d_t_b_msg == ERROR_INVALID_OPERATION) {
-            on(msgtype::error,
-               str_fmt(
-                   "Detour一个挂起的事务已经存在，事务还未提交就是重复执行了，流程:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                   "DetourTransactionBegin", __FILE__, __FUNCTION__, __LINE__));
-        }
-        DetourTransactionAbort();
-        return;
-    }
-
-    LONG d_u_t_msg = DetourUpdateThread(GetCurrentThread());
-    if (d_u_t_msg != NO_ERROR) {
-        if (d_u_t_msg == ERROR_NOT_ENOUGH_MEMORY) {
-            on(msgtype::error, str_fmt("Detour没有足够的内存来记录线程的标识，流程:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                                       "DetourUpdateThread", __FILE__, __FUNCTION__, __LINE__));
-        }
-        DetourTransactionAbort();
-        return;
-    }
-
-    for (auto &item : hookInfoHash) {
-        LONG d_a_ex = DetourAttachEx((PVOID *)&item.second.second.ptr(), (PVOID)item.second.first,
-                                     (PDETOUR_TRAMPOLINE *)&item.second.second.origin, 0, 0);
-        if (d_a_ex != NO_ERROR) {
-            if (d_a_ex == ERROR_INVALID_BLOCK) {
-                on(msgtype::error,
-                   str_fmt("Detour被引用的函数太小，不能Hook，目标Hook描述信息:[%s]，流程:[%s],文件:[%s] 函数: [%s] "
-                           "行:[%d]",
-                           item.second.second.describe().empty() ? "无" : item.second.second.describe().c_str(),
-                           "DetourAttachEx", __FILE__, __FUNCTION__, __LINE__));
-            }
-            else if (d_a_ex == ERROR_INVALID_HANDLE) {
-                on(msgtype::error,
-                   str_fmt("Detour 此Hook的目标地址为NULL或指向NULL指针，目标Hook描述信息:[%s]，流程:[%s],文件:[%s] "
-                           "函数: [%s] 行:[%d]",
-                           item.second.second.describe().empty() ? "无" : item.second.second.describe().c_str(),
-                           "DetourAttachEx", __FILE__, __FUNCTION__, __LINE__));
-            }
-            else if (d_a_ex == ERROR_INVALID_OPERATION) {
-                on(msgtype::error,
-                   str_fmt("Detour不存在挂起的事务，目标Hook描述信息:[%s]，流程:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                           item.second.second.describe().empty() ? "无" : item.second.second.describe().c_str(),
-                           "DetourAttachEx", __FILE__, __FUNCTION__, __LINE__));
-            }
-            else if (d_a_ex == ERROR_NOT_ENOUGH_MEMORY) {
-                on(msgtype::error,
-                   str_fmt("Detour没有足够的内存来记录线程的标识，目标Hook描述信息:[%s]，流程:[%s],文件:[%s] 函数: "
-                           "[%s] 行:[%d]",
-                           item.second.second.describe().empty() ? "无" : item.second.second.describe().c_str(),
-                           "DetourAttachEx", __FILE__, __FUNCTION__, __LINE__));
-            }
-            else {
-                on(msgtype::error,
-                   str_fmt("Detour DetourAttachEx返回未知错误:[%ld]，目标Hook描述信息:[%s]，流程:[%s],文件:[%s] 函数: "
-                           "[%s] 行:[%d]",
-                           d_a_ex, item.second.second.describe().empty() ? "无" : item.second.second.describe().c_str(),
-                           "DetourAttachEx", __FILE__, __FUNCTION__, __LINE__));
-            }
-        }
-    }
-    LONG d_t_c_msg = DetourTransactionCommit();
-    if (d_t_c_msg != NO_ERROR) {
-        if (d_t_c_msg == ERROR_INVALID_DATA) {
-            on(msgtype::error,
-               str_fmt("Detour目标函数在事务的各个步骤之间被第三方更改，流程:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                       "DetourTransactionCommit", __FILE__, __FUNCTION__, __LINE__));
-        }
-        else if (d_t_c_msg == ERROR_INVALID_OPERATION) {
-            on(msgtype::error, str_fmt("Detour不存在挂起的事务，流程:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                                       "DetourTransactionCommit", __FILE__, __FUNCTION__, __LINE__));
-        }
-        else {
-            on(msgtype::error,
-               str_fmt("Detour DetourTransactionCommit返回未知错误:[%ld]，流程:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                       d_t_c_msg, "DetourTransactionCommit", __FILE__, __FUNCTION__, __LINE__));
-        }
-        DetourTransactionAbort();
-        return;
-    }
 #endif // USE_DETOURS
 }
 
-inline auto HookManager::disableAllHook() -> void
-{
-    std::shared_lock<std::shared_mutex> guard(map_lock_mutex);
-
-#ifdef USE_LIGHTHOOK
-    for (auto &item : hookInfoHash) {
-        if (item.second.first.Enabled) {
-            if (!DisableHook(&item.second.first)) {
-                on(msgtype::error,
-                   str_fmt("LightHook DisableHook 关闭Hook失败，目标Hook描述信息:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                           item.second.second.describe().empty() ? "无" : item.second.second.describe().c_str(),
-                           __FILE__, __FUNCTION__, __LINE__));
-            }
-        }
-    }
-#endif // USE_LIGHTHOOK
-
-#ifdef USE_MINHOOK
-    for (auto &item : hookInfoHash) {
-        MH_STATUS status = MH_DisableHook((LPVOID)item.second.first);
-        if (status != MH_OK) {
-            on(msgtype::error,
-               str_fmt("MH_DisableHook 返回标识失败:[%s]，目标Hook描述信息:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                       MH_StatusToString(status),
-                       item.second.second.describe().empty() ? "无" : item.second.second.describe().c_str(), __FILE__,
-                       __FUNCTION__, __LINE__));
-        }
-    }
-#endif // USE_MINHOOK
-
-#ifdef USE_DETOURS
-    LONG d_t_b_msg = DetourTransactionBegin();
-    if (d_t_b_msg != NO_ERROR) {
-        if (d_t_b_msg == ERROR_INVALID_OPERATION) {
-            on(msgtype::error,
-               str_fmt(
-                   "Detour一个挂起的事务已经存在，事务还未提交就是重复执行了，流程:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                   "DetourTransactionBegin", __FILE__, __FUNCTION__, __LINE__));
-        }
-        DetourTransactionAbort();
-        return;
-    }
-
-    LONG d_u_t_msg = DetourUpdateThread(GetCurrentThread());
-    if (d_u_t_msg != NO_ERROR) {
-        if (d_u_t_msg == ERROR_NOT_ENOUGH_MEMORY) {
-            on(msgtype::error, str_fmt("Detour没有足够的内存来记录线程的标识，流程:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                                       "DetourUpdateThread", __FILE__, __FUNCTION__, __LINE__));
-        }
-        DetourTransactionAbort();
-        return;
-    }
-
-    for (auto &item : hookInfoHash) {
-        LONG d_d_msg = DetourDetach((PVOID *)&item.second.second.ptr(), (PVOID)item.second.first);
-        if (d_d_msg != NO_ERROR) {
-            if (d_d_msg == ERROR_INVALID_BLOCK) {
-                on(msgtype::error,
-                   str_fmt("Detour被引用的函数太小，不能Hook，目标Hook描述信息:[%s]，流程:[%s],文件:[%s] 函数: [%s] "
-                           "行:[%d]",
-                           item.second.second.describe().empty() ? "无" : item.second.second.describe().c_str(),
-                           "DetourDetach", __FILE__, __FUNCTION__, __LINE__));
-            }
-            else if (d_d_msg == ERROR_INVALID_HANDLE) {
-                on(msgtype::error,
-                   str_fmt("Detour 此Hook的目标地址为NULL或指向NULL指针，目标Hook描述信息:[%s]，流程:[%s],文件:[%s] "
-                           "函数: [%s] 行:[%d]",
-                           item.second.second.describe().empty() ? "无" : item.second.second.describe().c_str(),
-                           "DetourDetach", __FILE__, __FUNCTION__, __LINE__));
-            }
-            else if (d_d_msg == ERROR_INVALID_OPERATION) {
-                on(msgtype::error,
-                   str_fmt("Detour不存在挂起的事务，目标Hook描述信息:[%s]，流程:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                           item.second.second.describe().empty() ? "无" : item.second.second.describe().c_str(),
-                           "DetourDetach", __FILE__, __FUNCTION__, __LINE__));
-            }
-            else if (d_d_msg == ERROR_NOT_ENOUGH_MEMORY) {
-                on(msgtype::error,
-                   str_fmt("Detour没有足够的内存来记录线程的标识，目标Hook描述信息:[%s]，流程:[%s],文件:[%s] 函数: "
-                           "[%s] 行:[%d]",
-                           item.second.second.describe().empty() ? "无" : item.second.second.describe().c_str(),
-                           "DetourDetach", __FILE__, __FUNCTION__, __LINE__));
-            }
-            else {
-                on(msgtype::error,
-                   str_fmt("Detour DetourDetach返回未知错误:[%ld]，目标Hook描述信息:[%s]，流程:[%s],文件:[%s] 函数: "
-                           "[%s] 行:[%d]",
-                           d_d_msg,
-                           item.second.second.describe().empty() ? "无" : item.second.second.describe().c_str(),
-                           "DetourDetach", __FILE__, __FUNCTION__, __LINE__));
-            }
-        }
-    }
-    LONG d_t_c_msg = DetourTransactionCommit();
-    if (d_t_c_msg != NO_ERROR) {
-        if (d_t_c_msg == ERROR_INVALID_DATA) {
-            on(msgtype::error,
-               str_fmt("Detour目标函数在事务的各个步骤之间被第三方更改，流程:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                       "DetourTransactionCommit", __FILE__, __FUNCTION__, __LINE__));
-        }
-        else if (d_t_c_msg == ERROR_INVALID_OPERATION) {
-            on(msgtype::error, str_fmt("Detour不存在挂起的事务，流程:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                                       "DetourTransactionCommit", __FILE__, __FUNCTION__, __LINE__));
-        }
-        else {
-            on(msgtype::error,
-               str_fmt("Detour DetourTransactionCommit返回未知错误:[%ld]，流程:[%s],文件:[%s] 函数: [%s] 行:[%d]",
-                       d_t_c_msg, "DetourTransactionCommit", __FILE__, __FUNCTION__, __LINE__));
-        }
-        DetourTransactionAbort();
-        return;
-    }
-#endif // USE_DETOURS
-}
-
-inline auto HookManager::findHookInstance(uintptr_t indexptr) -> HookInstance *
-{
-    std::shared_lock<std::shared_mutex> guard(map_lock_mutex);
-    auto it = hookInfoHash.find(indexptr);
-    if (it != hookInfoHash.end()) {
-        return &((*it).second.second);
-    }
-    return nullptr;
-}
-
-inline auto HookManager::on(MessageEvent ev) -> void
-{
-    event = ev;
-}
-
-inline auto HookManager::on(msgtype type, std::string msg) -> void
-{
-    if (event) {
-        event(type, msg);
-    }
-}
-
 inline uintptr_t &HookInstance::ptr()
 {
     return m_ptr;
@@ -767,7 +789,11 @@ inline static std::string str_fmt(const char *fmt, ...)
     va_list arg;
     va_start(arg, fmt);
     char str[500];
+#ifdef _WIN32
     vsprintf_s(str, sizeof(str) - 1, fmt, arg);
+#else
+    vsnprintf(str, sizeof(str), fmt, arg);
+#endif
     va_end(arg);
     return str;
 }
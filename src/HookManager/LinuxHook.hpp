@@ -0,0 +1,337 @@
+/*
+ * Linux x86-64 下的 inline hook, 接口与 LightHook 一致 (CreateHook / EnableHook / DisableHook)
+ * 目标函数开头被改写为 5 字节的 jmp rel32, 跳到目标附近 ±2GB 内的中转区, 再绝对跳转到回调
+ */
+
+#pragma once
+#ifndef LINUXHOOK_HPP
+#define LINUXHOOK_HPP
+
+#include "../X64Decoder.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+struct HookInformation {
+    void *Address = nullptr;
+    void *Destination = nullptr;
+    /**
+     * @brief 搬移后的原函数开头, 调用它等于调用原函数, 创建失败时为 nullptr
+     */
+    void *Trampoline = nullptr;
+    int Enabled = 0;
+    /**
+     * @brief 被 jmp 覆盖的原始字节
+     */
+    uint8_t Original[8]{};
+    /**
+     * @brief 中转: 绝对跳转到 Destination, 与目标距离在 rel32 范围内
+     */
+    uint8_t *Relay = nullptr;
+};
+
+namespace LinuxHookDetail {
+constexpr size_t arenaSize = 64 * 1024;
+constexpr size_t patchSize = 5;
+constexpr size_t absJmpSize = 14;
+// 每个Hook占用的中转区: 16 字节中转 + 跳板 (搬移的指令和跳回原函数的绝对跳转)
+constexpr size_t slotSize = 128;
+constexpr intptr_t nearRange = 0x7FF00000;
+
+struct Arena {
+    uint8_t *base = nullptr;
+    size_t used = 0;
+};
+
+inline std::mutex arenaMutex;
+inline std::vector<Arena> arenas;
+
+inline bool isNear(uintptr_t a, uintptr_t b, size_t length)
+{
+    intptr_t low = (intptr_t)a - (intptr_t)b;
+    intptr_t high = (intptr_t)(a + length) - (intptr_t)b;
+    return low > -nearRange && low < nearRange && high > -nearRange && high < nearRange;
+}
+
+inline uint8_t *tryMapAt(uintptr_t hint)
+{
+#ifdef MAP_FIXED_NOREPLACE
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE;
+#else
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#endif
+    void *p = mmap((void *)hint, arenaSize, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (p == MAP_FAILED) {
+        return nullptr;
+    }
+    if ((uintptr_t)p != hint) {
+        // 旧内核不认识 MAP_FIXED_NOREPLACE, 只把地址当作提示
+        munmap(p, arenaSize);
+        return nullptr;
+    }
+    // 中转区平时只读可执行, 写入中转和跳板时由 writeCode 临时加上写权限
+    if (mprotect(p, arenaSize, PROT_READ | PROT_EXEC) != 0) {
+        munmap(p, arenaSize);
+        return nullptr;
+    }
+    return (uint8_t *)p;
+}
+
+/**
+ * @brief 在 target 附近 ±2GB 内分配一段可执行内存, 中转区只增不减
+ */
+inline uint8_t *allocateNear(uintptr_t target, size_t size)
+{
+    std::lock_guard<std::mutex> guard(arenaMutex);
+    for (auto &arena : arenas) {
+        if (arena.used + size <= arenaSize && isNear((uintptr_t)arena.base, target, arenaSize)) {
+            auto p = arena.base + arena.used;
+            arena.used += size;
+            return p;
+        }
+    }
+    uintptr_t aligned = target & ~(uintptr_t)(arenaSize - 1);
+    for (uintptr_t distance = arenaSize; distance < (uintptr_t)nearRange - arenaSize; distance += arenaSize) {
+        for (uintptr_t hint : {aligned - distance, aligned + distance}) {
+            if (hint < arenaSize || !isNear(hint, target, arenaSize)) {
+                continue;
+            }
+            if (auto base = tryMapAt(hint)) {
+                arenas.push_back({base, size});
+                return base;
+            }
+        }
+    }
+    return nullptr;
+}
+
+inline void writeAbsJmp(uint8_t *at, uintptr_t destination)
+{
+    // jmp qword ptr [rip+0]; dq destination
+    static constexpr uint8_t jmp[] = {0xFF, 0x25, 0x00, 0x00, 0x00, 0x00};
+    std::memcpy(at, jmp, sizeof(jmp));
+    std::memcpy(at + sizeof(jmp), &destination, sizeof(destination));
+}
+
+inline bool fitsRel32(intptr_t value)
+{
+    return value >= INT32_MIN && value <= INT32_MAX;
+}
+
+/**
+ * @brief 把目标开头至少 patchSize 字节的完整指令搬到 out, 修正 RIP 相对寻址和相对跳转
+ * @param outAddress 搬移后的指令最终所在的地址, out 只是写入用的缓冲区
+ * @return 搬移后的长度, 无法搬移时返回 0
+ */
+inline size_t relocate(const uint8_t *source, uint8_t *out, uintptr_t outAddress, size_t &copied)
+{
+    size_t written = 0;
+    copied = 0;
+    while (copied < patchSize) {
+        X64Instruction insn;
+        const uint8_t *at = source + copied;
+        if (!decodeX64(at, 15, insn)) {
+            return 0;
+        }
+        uintptr_t oldNext = (uintptr_t)at + insn.length;
+        uint8_t *dst = out + written;
+        uintptr_t dstAddress = outAddress + written;
+
+        if (insn.relativeBranch) {
+            intptr_t rel = insn.immSize == 1 ? (int8_t)at[insn.immOffset] : *(const int32_t *)(at + insn.immOffset);
+            uintptr_t branchTarget = oldNext + rel;
+            // 跳回被覆盖区域内部的分支无法保持正确
+            if (branchTarget > (uintptr_t)source && branchTarget < (uintptr_t)source + patchSize) {
+                return 0;
+            }
+            size_t length;
+            if (insn.immSize == 1) {
+                if (insn.opcodeMap != 0 || (insn.opcode >= 0xE0 && insn.opcode <= 0xE3)) {
+                    // loop / jrcxz 没有 rel32 形式
+                    return 0;
+                }
+                if (insn.opcode == 0xEB) {
+                    dst[0] = 0xE9;
+                    length = 5;
+                }
+                else {
+                    dst[0] = 0x0F;
+                    dst[1] = (uint8_t)(0x80 | (insn.opcode & 0x0F));
+                    length = 6;
+                }
+            }
+            else {
+                length = insn.length;
+                std::memcpy(dst, at, length);
+            }
+            intptr_t newRel = (intptr_t)branchTarget - (intptr_t)(dstAddress + length);
+            if (!fitsRel32(newRel)) {
+                return 0;
+            }
+            int32_t rel32 = (int32_t)newRel;
+            std::memcpy(dst + length - 4, &rel32, 4);
+            written += length;
+        }
+        else {
+            std::memcpy(dst, at, insn.length);
+            if (insn.ripRelative) {
+                intptr_t newDisp = *(const int32_t *)(at + insn.dispOffset) + ((intptr_t)at - (intptr_t)dstAddress);
+                if (!fitsRel32(newDisp)) {
+                    return 0;
+                }
+                int32_t disp32 = (int32_t)newDisp;
+                std::memcpy(dst + insn.dispOffset, &disp32, 4);
+            }
+            written += insn.length;
+        }
+        copied += insn.length;
+
+        // 函数在覆盖范围内就结束了, 再往后写会破坏相邻的代码
+        bool ends = insn.opcodeMap == 0
+                 && (insn.opcode == 0xC3 || insn.opcode == 0xC2 || insn.opcode == 0xCC || insn.opcode == 0xE9
+                     || insn.opcode == 0xEB);
+        if (ends && copied < patchSize) {
+            return 0;
+        }
+    }
+    return written;
+}
+
+/**
+ * @brief 从 /proc/self/maps 读出 [begin, end) 的保护属性
+ * @return 范围没有被完整映射, 或其中各段的属性不同时返回 false
+ */
+inline bool currentProtection(uintptr_t begin, uintptr_t end, int &prot)
+{
+    std::ifstream maps("/proc/self/maps");
+    std::string line;
+    uintptr_t covered = begin;
+    bool found = false;
+    while (covered < end && std::getline(maps, line)) {
+        unsigned long low = 0;
+        unsigned long high = 0;
+        char perms[5]{};
+        if (std::sscanf(line.c_str(), "%lx-%lx %4s", &low, &high, perms) != 3) {
+            continue;
+        }
+        if (high <= covered || low > covered) {
+            continue;
+        }
+        int p = (perms[0] == 'r' ? PROT_READ : 0) | (perms[1] == 'w' ? PROT_WRITE : 0)
+              | (perms[2] == 'x' ? PROT_EXEC : 0);
+        if (found && p != prot) {
+            return false;
+        }
+        prot = p;
+        found = true;
+        covered = high;
+    }
+    return found && covered >= end;
+}
+
+/**
+ * @brief 临时给所在页加上写权限后写入, 之后恢复原来的保护属性
+ * 恢复失败时写回原来的字节并返回 false, 不留下可写的代码页
+ */
+inline bool writeCode(void *address, const void *data, size_t size)
+{
+    static const uintptr_t pageSize = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t begin = (uintptr_t)address & ~(pageSize - 1);
+    uintptr_t end = ((uintptr_t)address + size + pageSize - 1) & ~(pageSize - 1);
+    int prot = 0;
+    if (!currentProtection(begin, end, prot)) {
+        return false;
+    }
+    if (mprotect((void *)begin, end - begin, prot | PROT_WRITE) != 0) {
+        return false;
+    }
+    std::vector<uint8_t> previous((const uint8_t *)address, (const uint8_t *)address + size);
+    std::memcpy(address, data, size);
+    if (mprotect((void *)begin, end - begin, prot) != 0) {
+        std::memcpy(address, previous.data(), size);
+        mprotect((void *)begin, end - begin, prot);
+        return false;
+    }
+    __builtin___clear_cache((char *)address, (char *)address + size);
+    return true;
+}
+} // namespace LinuxHookDetail
+
+/**
+ * @brief 准备Hook: 分配中转和跳板, 此时还没有修改目标函数
+ */
+inline HookInformation CreateHook(void *address, void *destination)
+{
+    using namespace LinuxHookDetail;
+    HookInformation info;
+    info.Address = address;
+    info.Destination = destination;
+    if (!address || !destination) {
+        return info;
+    }
+    uint8_t *slot = allocateNear((uintptr_t)address, slotSize);
+    if (!slot) {
+        return info;
+    }
+    // 先在缓冲区中生成中转和跳板, 再一次写入只读的中转区
+    uint8_t code[slotSize]{};
+    uint8_t *trampoline = slot + 16;
+    size_t copied = 0;
+    size_t written = relocate((const uint8_t *)address, code + 16, (uintptr_t)trampoline, copied);
+    if (!written || written + absJmpSize > slotSize - 16) {
+        return info;
+    }
+    writeAbsJmp(code, (uintptr_t)destination);
+    writeAbsJmp(code + 16 + written, (uintptr_t)address + copied);
+    if (!writeCode(slot, code, 16 + written + absJmpSize)) {
+        return info;
+    }
+    std::memcpy(info.Original, address, patchSize);
+    info.Relay = slot;
+    info.Trampoline = trampoline;
+    return info;
+}
+
+inline int EnableHook(HookInformation *info)
+{
+    using namespace LinuxHookDetail;
+    if (!info || !info->Trampoline) {
+        return 0;
+    }
+    if (info->Enabled) {
+        return 1;
+    }
+    uint8_t patch[patchSize] = {0xE9};
+    int32_t rel32 = (int32_t)((intptr_t)info->Relay - ((intptr_t)info->Address + (intptr_t)patchSize));
+    std::memcpy(patch + 1, &rel32, 4);
+    if (!writeCode(info->Address, patch, patchSize)) {
+        return 0;
+    }
+    info->Enabled = 1;
+    return 1;
+}
+
+inline int DisableHook(HookInformation *info)
+{
+    using namespace LinuxHookDetail;
+    if (!info || !info->Trampoline) {
+        return 0;
+    }
+    if (!info->Enabled) {
+        return 1;
+    }
+    if (!writeCode(info->Address, info->Original, patchSize)) {
+        return 0;
+    }
+    info->Enabled = 0;
+    return 1;
+}
+
+#endif // LINUXHOOK_HPP
@@ -0,0 +1,33 @@
+#pragma once
+#include "MapData.h"
+
+#include <cstddef>
+#include <vector>
+
+struct SweepResult {
+    /**
+     * @brief 实际执行的遍历次数, 被快速判断跳过时为 0
+     */
+    size_t sweeps = 0;
+    size_t maps = 0;
+    size_t trackers = 0;
+    size_t removed = 0;
+};
+
+/**
+ * @brief 从所有地图的跟踪列表中移除跟踪指定实体的 MapItemTrackedActor
+ * @param uniqueId 实体的 ActorUniqueID
+ */
+inline SweepResult sweepTrackers(ServerMapDataManager *manager, int64_t uniqueId)
+{
+    SweepResult result;
+    result.sweeps = 1;
+    for (auto &[id, data] : MapLayout::allMapData(manager)) {
+        auto &v = MapLayout::trackers(data.get());
+        result.maps++;
+        result.trackers += v.size();
+        result.removed +=
+            std::erase_if(v, [uniqueId](auto &ptr) { return MapLayout::trackedId(ptr.get()) == uniqueId; });
+    }
+    return result;
+}
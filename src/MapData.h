@@ -0,0 +1,183 @@
+#pragma once
+#include "Memory.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class ServerNetworkHandler {};
+class Actor {};
+class BlockActor {};
+class BlockSource {};
+class ServerPlayer {};
+class ServerLevel {};
+class ServerMapDataManager {};
+struct ActorUniqueID {
+public:
+    int64_t id{};
+};
+class MapItemSavedData {};
+class MapItemTrackedActor {};
+
+struct BlockPos {
+    int x{};
+    int y{};
+    int z{};
+
+    bool operator==(const BlockPos &) const = default;
+};
+
+/**
+ * @brief MapItemTrackedActor::UniqueId::Type
+ */
+enum class TrackedType : int {
+    Entity = 0,
+    BlockEntity = 1,
+};
+
+inline bool operator==(const ActorUniqueID &a, const ActorUniqueID &b)
+{
+    return a.id == b.id;
+}
+
+template <>
+struct std::hash<ActorUniqueID> {
+    size_t operator()(const ActorUniqueID &id) const noexcept
+    {
+        return std::hash<int64_t>()(id.id);
+    }
+};
+
+using MapDataMap = std::unordered_map<ActorUniqueID, std::unique_ptr<MapItemSavedData>>;
+using TrackerList = std::vector<std::shared_ptr<MapItemTrackedActor>>;
+
+/**
+ * @brief BDS 内部对象中用到的字段偏移
+ */
+namespace MapLayout {
+/**
+ * @brief 无法从现有代码确认的偏移, 由 config.json 提供, 小于 0 表示未知, 相关功能不启用
+ */
+inline ptrdiff_t mapDimensionOffset = -1;
+inline ptrdiff_t blockActorPositionOffset = -1;
+inline ptrdiff_t mapOriginOffset = -1;
+inline ptrdiff_t mapScaleOffset = -1;
+inline ptrdiff_t mapPixelsOffset = -1;
+inline ptrdiff_t blockSourceLevelOffset = -1;
+inline ptrdiff_t blockSourceDimensionOffset = -1;
+inline ptrdiff_t dimensionIdOffset = -1;
+inline ptrdiff_t actorUniqueIdOffset = -1;
+
+/**
+ * @brief Actor 所在的 ServerLevel
+ */
+inline ServerLevel *level(const void *actor)
+{
+    return dAccess<ServerLevel *>(actor, 0x1d8);
+}
+
+/**
+ * @brief ServerMapDataManager 中所有已加载的地图数据
+ */
+inline MapDataMap &allMapData(ServerMapDataManager *manager)
+{
+    return dAccess<MapDataMap>(manager, 0x70);
+}
+
+/**
+ * @brief MapItemSavedData 中正在跟踪这张地图的实体
+ */
+inline TrackerList &trackers(MapItemSavedData *data)
+{
+    return dAccess<TrackerList>(data, 0x60);
+}
+
+/**
+ * @brief 地图所属的维度 (DimensionType), 需要 mapDimensionOffset
+ */
+inline int dimension(const MapItemSavedData *data)
+{
+    return dAccess<int>(data, mapDimensionOffset);
+}
+
+/**
+ * @brief 地图中心的方块坐标, 需要 mapOriginOffset
+ */
+inline const BlockPos &mapOrigin(const MapItemSavedData *data)
+{
+    return dAccess<BlockPos>(data, mapOriginOffset);
+}
+
+/**
+ * @brief 地图的缩放比例 (0 - 4), 需要 mapScaleOffset
+ */
+inline int8_t mapScale(const MapItemSavedData *data)
+{
+    return dAccess<int8_t>(data, mapScaleOffset);
+}
+
+/**
+ * @brief 地图的像素缓冲区 (128 * 128 个颜色), 需要 mapPixelsOffset; 缓冲区属于服务端, 只读
+ */
+inline const std::vector<uint32_t> &pixels(const MapItemSavedData *data)
+{
+    return dAccess<std::vector<uint32_t>>(data, mapPixelsOffset);
+}
+
+/**
+ * @brief 方块实体的坐标, 需要 blockActorPositionOffset
+ */
+inline const BlockPos &blockActorPos(const BlockActor *blockActor)
+{
+    return dAccess<BlockPos>(blockActor, blockActorPositionOffset);
+}
+
+/**
+ * @brief Actor 已有的 UniqueID, 需要 actorUniqueIdOffset; 还没有分配时为 -1, 不会像 getOrCreateUniqueID 那样分配
+ */
+inline int64_t actorUniqueId(const Actor *actor)
+{
+    return dAccess<ActorUniqueID>(actor, actorUniqueIdOffset).id;
+}
+
+/**
+ * @brief BlockSource 所属的 ServerLevel, 需要 blockSourceLevelOffset
+ */
+inline ServerLevel *regionLevel(const BlockSource *region)
+{
+    return dAccess<ServerLevel *>(region, blockSourceLevelOffset);
+}
+
+/**
+ * @brief BlockSource 所属维度的 DimensionType, 需要 blockSourceDimensionOffset (Dimension*) 和 dimensionIdOffset
+ */
+inline int regionDimension(const BlockSource *region)
+{
+    return dAccess<int>(dAccess<const void *>(region, blockSourceDimensionOffset), dimensionIdOffset);
+}
+
+/**
+ * @brief MapItemTrackedActor 跟踪的是实体还是方块实体 (物品展示框)
+ */
+inline TrackedType trackedType(const MapItemTrackedActor *tracker)
+{
+    return dAccess<TrackedType>(tracker, 0x0);
+}
+
+/**
+ * @brief MapItemTrackedActor 所跟踪实体的 UniqueID
+ */
+inline int64_t trackedId(const MapItemTrackedActor *tracker)
+{
+    return dAccess<ActorUniqueID>(tracker, 0x8).id;
+}
+
+/**
+ * @brief MapItemTrackedActor 所跟踪方块实体的位置
+ */
+inline const BlockPos &trackedBlockPos(const MapItemTrackedActor *tracker)
+{
+    return dAccess<BlockPos>(tracker, 0x10);
+}
+} // namespace MapLayout
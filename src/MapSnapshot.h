@@ -0,0 +1,183 @@
+#pragma once
+#include "MapData.h"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fmt/format.h>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 把 ServerMapDataManager 中所有地图的跟踪者写成 JSON, 用于对比多次快照找出泄漏来源
+ * 遍历分摊到多个 tick 中, 每个 tick 只在预算时间内写若干张地图, 必须在服务器线程调用
+ * 文件格式: {"startedAt": 秒, "maps": [每张地图一个对象], "summary": {...}}
+ */
+class MapSnapshot {
+public:
+    /**
+     * @brief 一个 MapItemTrackedActor 对象 (含 shared_ptr 控制块) 的估计大小, 没有确切的 sizeof
+     */
+    static constexpr size_t estimatedTrackerBytes = 128;
+    /**
+     * @brief 像素缓冲区偏移未知时按完整的 128 * 128 个颜色估计
+     */
+    static constexpr size_t defaultPixelBytes = 128 * 128 * sizeof(uint32_t);
+
+private:
+    std::ofstream out;
+    std::filesystem::path path_;
+    /**
+     * @brief 开始时的地图 id, 之后每个 tick 重新按 id 查找, 期间被卸载的地图直接跳过
+     */
+    std::vector<ActorUniqueID> pending;
+    size_t next = 0;
+    bool firstMap = true;
+
+    std::chrono::steady_clock::time_point startedAt;
+    std::chrono::steady_clock::duration walkTime{};
+    size_t ticks = 0;
+    size_t maps = 0;
+    size_t trackers = 0;
+    size_t estimatedBytes = 0;
+
+    static size_t estimateBytes(MapItemSavedData *data)
+    {
+        auto &list = MapLayout::trackers(data);
+        size_t pixels = MapLayout::mapPixelsOffset >= 0 ? MapLayout::pixels(data).capacity() * sizeof(uint32_t)
+                                                        : defaultPixelBytes;
+        return pixels + list.capacity() * sizeof(list[0]) + list.size() * estimatedTrackerBytes;
+    }
+
+    void writeMap(const ActorUniqueID &id, MapItemSavedData *data)
+    {
+        auto &list = MapLayout::trackers(data);
+        auto actors = nlohmann::json::array();
+        auto blocks = nlohmann::json::array();
+        for (auto &tracker : list) {
+            if (!tracker) {
+                continue;
+            }
+            if (MapLayout::trackedType(tracker.get()) == TrackedType::BlockEntity) {
+                auto &pos = MapLayout::trackedBlockPos(tracker.get());
+                blocks.push_back({pos.x, pos.y, pos.z});
+            }
+            else {
+                actors.push_back(MapLayout::trackedId(tracker.get()));
+            }
+        }
+        size_t bytes = estimateBytes(data);
+        nlohmann::json map = {
+            {"id", id.id},
+            {"trackers", list.size()},
+            {"actorTrackers", std::move(actors)},
+            {"blockTrackers", std::move(blocks)},
+            {"estimatedBytes", bytes},
+        };
+        if (MapLayout::mapDimensionOffset >= 0) {
+            map["dimension"] = MapLayout::dimension(data);
+        }
+        out << (firstMap ? "\n" : ",\n") << map.dump();
+        firstMap = false;
+        maps++;
+        trackers += list.size();
+        estimatedBytes += bytes;
+    }
+
+public:
+    bool running() const
+    {
+        return out.is_open();
+    }
+
+    const std::filesystem::path &path() const
+    {
+        return path_;
+    }
+
+    /**
+     * @brief 开始一次快照, 已有快照在进行时返回 false
+     */
+    bool begin(const std::filesystem::path &file, ServerMapDataManager *manager)
+    {
+        if (running() || !manager) {
+            return false;
+        }
+        std::error_code ec;
+        std::filesystem::create_directories(file.parent_path(), ec);
+        out.open(file, std::ios::out | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        path_ = file;
+        pending.clear();
+        for (auto &[id, data] : MapLayout::allMapData(manager)) {
+            pending.push_back(id);
+        }
+        next = 0;
+        firstMap = true;
+        startedAt = std::chrono::steady_clock::now();
+        walkTime = {};
+        ticks = maps = trackers = estimatedBytes = 0;
+        auto epoch = std::chrono::system_clock::now().time_since_epoch();
+        out << "{\"startedAt\": " << std::chrono::duration_cast<std::chrono::seconds>(epoch).count()
+            << ", \"maps\": [";
+        return true;
+    }
+
+    /**
+     * @brief 每个 tick 调用一次, 写到超出预算为止 (至少写一张地图, 保证能结束)
+     * @return 快照在本次调用中完成时返回 true
+     */
+    bool step(ServerMapDataManager *manager, std::chrono::steady_clock::duration budget)
+    {
+        if (!running()) {
+            return false;
+        }
+        auto begin = std::chrono::steady_clock::now();
+        auto &all = MapLayout::allMapData(manager);
+        ticks++;
+        do {
+            if (next >= pending.size()) {
+                break;
+            }
+            auto &id = pending[next++];
+            if (auto it = all.find(id); it != all.end() && it->second) {
+                writeMap(id, it->second.get());
+            }
+        } while (std::chrono::steady_clock::now() - begin < budget);
+        walkTime += std::chrono::steady_clock::now() - begin;
+        if (next < pending.size()) {
+            return false;
+        }
+        finish();
+        return true;
+    }
+
+    std::string summary() const
+    {
+        return fmt::format("{} maps, {} trackers, ~{} KiB, walked in {:.2f} ms over {} ticks", maps, trackers,
+                           estimatedBytes / 1024, std::chrono::duration<double, std::milli>(walkTime).count(), ticks);
+    }
+
+private:
+    void finish()
+    {
+        nlohmann::json summary = {
+            {"maps", maps},
+            {"trackers", trackers},
+            {"estimatedBytes", estimatedBytes},
+            {"ticks", ticks},
+            {"walkUs", std::chrono::duration_cast<std::chrono::microseconds>(walkTime).count()},
+            {"elapsedMs",
+             std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startedAt)
+                 .count()},
+        };
+        out << "\n], \"summary\": " << summary.dump() << "}\n";
+        out.close();
+        pending.clear();
+        pending.shrink_to_fit();
+    }
+};
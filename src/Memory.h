@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+template <class T>
+[[nodiscard]] constexpr T &dAccess(void *ptr, ptrdiff_t off)
+{
+    return *(T *)((uintptr_t)((uintptr_t)ptr + off));
+}
+
+template <class T>
+[[nodiscard]] constexpr T const &dAccess(void const *ptr, ptrdiff_t off)
+{
+    return *(T *)((uintptr_t)((uintptr_t)ptr + off));
+}
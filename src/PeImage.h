@@ -0,0 +1,96 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * @brief 不依赖 windows.h 的最小 PE 头解析, 内存中的模块和磁盘上的文件都可以用
+ */
+struct PeSection {
+    char name[9]{};
+    uint32_t virtualAddress = 0;
+    uint32_t virtualSize = 0;
+    uint32_t rawOffset = 0;
+    uint32_t rawSize = 0;
+    uint32_t characteristics = 0;
+
+    bool executable() const
+    {
+        return characteristics & 0x20000000; // IMAGE_SCN_MEM_EXECUTE
+    }
+};
+
+/**
+ * @brief 用于判断两个文件是否为同一个构建
+ */
+struct PeBuildId {
+    uint32_t timeDateStamp = 0;
+    uint32_t sizeOfImage = 0;
+    uint32_t checkSum = 0;
+
+    bool operator==(const PeBuildId &) const = default;
+};
+
+struct PeInfo {
+    PeBuildId buildId;
+    uint32_t sizeOfHeaders = 0;
+    std::vector<PeSection> sections;
+};
+
+/**
+ * @brief 解析 PE32+ 头
+ * @param data 文件或模块的起始地址
+ * @param size 可读取的字节数
+ * @return 不是合法的 PE32+ 时返回 false
+ */
+inline bool parsePe(const uint8_t *data, size_t size, PeInfo &info)
+{
+    auto read16 = [&](size_t off) {
+        uint16_t v;
+        std::memcpy(&v, data + off, sizeof(v));
+        return v;
+    };
+    auto read32 = [&](size_t off) {
+        uint32_t v;
+        std::memcpy(&v, data + off, sizeof(v));
+        return v;
+    };
+
+    if (size < 0x40 || read16(0) != 0x5A4D) { // MZ
+        return false;
+    }
+    size_t nt = read32(0x3C);
+    if (nt + 24 > size || read32(nt) != 0x00004550) { // PE\0\0
+        return false;
+    }
+    size_t fileHeader = nt + 4;
+    uint16_t numberOfSections = read16(fileHeader + 2);
+    uint16_t sizeOfOptionalHeader = read16(fileHeader + 16);
+    size_t optional = fileHeader + 20;
+    if (optional + sizeOfOptionalHeader > size || sizeOfOptionalHeader < 0x44 || read16(optional) != 0x20B) {
+        return false;
+    }
+    info.buildId.timeDateStamp = read32(fileHeader + 4);
+    info.buildId.sizeOfImage = read32(optional + 56);
+    info.sizeOfHeaders = read32(optional + 60);
+    info.buildId.checkSum = read32(optional + 64);
+
+    size_t sectionTable = optional + sizeOfOptionalHeader;
+    if (sectionTable + numberOfSections * 40ull > size) {
+        return false;
+    }
+    info.sections.clear();
+    for (uint16_t i = 0; i < numberOfSections; i++) {
+        size_t sh = sectionTable + i * 40ull;
+        PeSection section;
+        std::memcpy(section.name, data + sh, 8);
+        section.virtualSize = read32(sh + 8);
+        section.virtualAddress = read32(sh + 12);
+        section.rawSize = read32(sh + 16);
+        section.rawOffset = read32(sh + 20);
+        section.characteristics = read32(sh + 36);
+        info.sections.push_back(section);
+    }
+    return true;
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum class ReclaimMode {
+    /**
+     * @brief 清理时直接释放
+     */
+    Immediate,
+    /**
+     * @brief 攒到本 tick 的定时任务中统一释放
+     */
+    TickEnd,
+};
+
+/**
+ * @brief 解析配置中的 reclaimMode, 无法识别时按 immediate 处理
+ * 原来的 thread 模式在后台线程析构跟踪者, 与服务器线程竞争, 已移除, 按 tick 处理
+ */
+inline ReclaimMode parseReclaimMode(const std::string &name)
+{
+    if (name == "tick" || name == "thread") {
+        return ReclaimMode::TickEnd;
+    }
+    return ReclaimMode::Immediate;
+}
+
+inline const char *reclaimModeName(ReclaimMode mode)
+{
+    switch (mode) {
+    case ReclaimMode::TickEnd:
+        return "tick";
+    default:
+        return "immediate";
+    }
+}
+
+/**
+ * @brief 延迟释放清理时移除的元素, 把 shared_ptr 的引用计数递减和析构移出玩家离开等延迟敏感的路径
+ * retire 可以在任何线程调用 (Hook 回调不一定在服务器线程), flush 只在 tick 任务中调用
+ * 元素总是在服务器线程的 flush 中析构, 跟踪者的析构函数不会与服务端修改区块/视野状态并发执行
+ */
+template <typename T>
+class Reclaimer {
+    ReclaimMode mode_ = ReclaimMode::Immediate;
+
+    mutable std::mutex pendingMutex;
+    /**
+     * @brief 本 tick 攒下的元素, 由 pendingMutex 保护
+     */
+    std::vector<T> pending;
+    /**
+     * @brief flush 从 pending 换出的一批, 只在 flush 中使用, 换回时保留容量
+     */
+    std::vector<T> flushing;
+
+    std::atomic<uint64_t> released{0};
+    std::atomic<uint64_t> batches{0};
+
+    void releaseBatch(std::vector<T> &batch)
+    {
+        if (batch.empty()) {
+            return;
+        }
+        released += batch.size();
+        batches++;
+        // clear 保留容量, 下一批不必重新分配
+        batch.clear();
+    }
+
+public:
+    Reclaimer() = default;
+    Reclaimer(const Reclaimer &) = delete;
+    Reclaimer &operator=(const Reclaimer &) = delete;
+    ~Reclaimer()
+    {
+        stop();
+    }
+
+    void start(ReclaimMode mode)
+    {
+        stop();
+        mode_ = mode;
+    }
+
+    /**
+     * @brief 释放所有剩余元素, 之后回到 Immediate 模式
+     */
+    void stop()
+    {
+        releaseBatch(flushing);
+        {
+            std::lock_guard<std::mutex> guard(pendingMutex);
+            releaseBatch(pending);
+        }
+        mode_ = ReclaimMode::Immediate;
+    }
+
+    ReclaimMode mode() const
+    {
+        return mode_;
+    }
+
+    void retire(T &&element)
+    {
+        std::lock_guard<std::mutex> guard(pendingMutex);
+        pending.push_back(std::move(element));
+    }
+
+    /**
+     * @brief 每个 tick 调用一次, 释放本 tick 攒下的元素
+     */
+    void flush()
+    {
+        {
+            // 只在锁内交换, 析构在锁外进行, 不阻塞其他线程的 retire
+            std::lock_guard<std::mutex> guard(pendingMutex);
+            if (pending.empty()) {
+                return;
+            }
+            pending.swap(flushing);
+        }
+        releaseBatch(flushing);
+    }
+
+    std::string report() const
+    {
+        size_t waiting;
+        {
+            std::lock_guard<std::mutex> guard(pendingMutex);
+            waiting = pending.size();
+        }
+        return std::string("reclaim: mode ") + reclaimModeName(mode_) + ", " + std::to_string(released.load())
+             + " released in " + std::to_string(batches.load()) + " batches, " + std::to_string(waiting)
+             + " pending";
+    }
+};
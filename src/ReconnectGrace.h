@@ -0,0 +1,117 @@
+#pragma once
+#include "MapData.h"
+#include "ServerThread.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <fmt/format.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 玩家离开后先暂存其 UniqueID, 宽限期内重新加入则取消清理, 超时后才清理跟踪者
+ * 连接不稳定的玩家频繁断开重连时, 避免每次都全量遍历地图再由服务端重建跟踪者
+ * 不加锁, 所有方法都在服务器线程调用: 离开的玩家由 tick 任务从离开队列中取出后暂存, 加入和超时也在服务器线程处理
+ */
+class ReconnectGrace {
+    struct Parked {
+        ServerLevel *level;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    std::chrono::steady_clock::duration window{};
+    std::unordered_map<int64_t, Parked> parked;
+
+    uint64_t parkedTotal = 0;
+    uint64_t rejoined = 0;
+    uint64_t expired = 0;
+
+public:
+    /**
+     * @param graceWindow 宽限期, 为 0 时不暂存, 离开时直接清理
+     */
+    void configure(std::chrono::steady_clock::duration graceWindow)
+    {
+        window = graceWindow;
+    }
+
+    bool enabled() const
+    {
+        return window > std::chrono::steady_clock::duration::zero();
+    }
+
+    /**
+     * @brief 暂存离开的玩家, 宽限期内重复离开时从最后一次离开重新计时
+     */
+    void park(ServerLevel *level, int64_t uniqueId)
+    {
+        assert(ServerThread::isCurrent());
+        parked[uniqueId] = {level, std::chrono::steady_clock::now() + window};
+        parkedTotal++;
+    }
+
+    /**
+     * @brief 玩家重新加入
+     * @return 该玩家的清理被取消时返回 true
+     */
+    bool cancel(int64_t uniqueId)
+    {
+        assert(ServerThread::isCurrent());
+        if (parked.erase(uniqueId)) {
+            rejoined++;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief 取出所有已超过宽限期的玩家, 由调用者清理, 每个 tick 调用一次
+     */
+    template <typename Fn>
+    void takeExpired(Fn &&sweep)
+    {
+        assert(ServerThread::isCurrent());
+        if (parked.empty()) {
+            return;
+        }
+        auto now = std::chrono::steady_clock::now();
+        std::vector<std::pair<int64_t, ServerLevel *>> due;
+        for (auto it = parked.begin(); it != parked.end();) {
+            if (it->second.deadline <= now) {
+                due.emplace_back(it->first, it->second.level);
+                it = parked.erase(it);
+                continue;
+            }
+            ++it;
+        }
+        expired += due.size();
+        for (auto &[uniqueId, level] : due) {
+            sweep(level, uniqueId);
+        }
+    }
+
+    /**
+     * @brief 不等宽限期结束, 取出所有暂存的玩家交给调用者清理, 插件卸载时调用
+     */
+    template <typename Fn>
+    void takeAll(Fn &&sweep)
+    {
+        assert(ServerThread::isCurrent());
+        auto all = std::move(parked);
+        parked.clear();
+        expired += all.size();
+        for (auto &[uniqueId, entry] : all) {
+            sweep(entry.level, uniqueId);
+        }
+    }
+
+    std::string report() const
+    {
+        return fmt::format("reconnect grace: {:.0f} s, {} waiting, {} parked, {} rejoined in time, {} swept",
+                           std::chrono::duration<double>(window).count(), parked.size(), parkedTotal, rejoined,
+                           expired);
+    }
+};
@@ -0,0 +1,22 @@
+#pragma once
+#include <atomic>
+#include <thread>
+
+/**
+ * @brief 记录服务器线程, 用于检查只能在服务器线程访问的结构 (地图数据, 回收队列, 重连宽限表等)
+ * 插件的 tick 任务在服务器线程执行, 每个 tick 绑定一次; 绑定之前不做检查
+ */
+namespace ServerThread {
+inline std::atomic<std::thread::id> bound{};
+
+inline void bind()
+{
+    bound.store(std::this_thread::get_id(), std::memory_order_relaxed);
+}
+
+inline bool isCurrent()
+{
+    auto id = bound.load(std::memory_order_relaxed);
+    return id == std::thread::id{} || id == std::this_thread::get_id();
+}
+} // namespace ServerThread
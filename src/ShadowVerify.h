@@ -0,0 +1,90 @@
+#pragma once
+#include "MapCleanup.h"
+#include "MapData.h"
+
+#include <cstdint>
+#include <fmt/format.h>
+#include <string>
+
+/**
+ * @brief 抽样核对优化后的清理: 对一部分清理在优化路径之后再用最初的 erase_if 全量遍历 (sweepTrackers) 检查一次
+ * 全量遍历找到的跟踪者就是优化路径漏掉的 (布隆过滤器误判为没有跟踪者, 规则遗漏等), 顺便移除它们
+ * 所有方法都在服务器线程调用
+ */
+class ShadowVerifier {
+    double rate = 0;
+    /**
+     * @brief 每次清理累加 rate, 满 1 时核对一次, 抽样均匀且不需要随机数
+     */
+    double credit = 0;
+
+    uint64_t verified = 0;
+    uint64_t mismatches = 0;
+    uint64_t leftovers = 0;
+    /**
+     * @brief 优化路径被快速判断跳过, 但全量遍历仍找到跟踪者的次数
+     */
+    uint64_t skippedMismatches = 0;
+    int64_t lastMismatchId = 0;
+
+public:
+    /**
+     * @param sampleRate 核对的清理比例, 0 表示关闭, 1 表示每次都核对
+     */
+    void configure(double sampleRate)
+    {
+        rate = sampleRate < 0 ? 0 : (sampleRate > 1 ? 1 : sampleRate);
+    }
+
+    bool enabled() const
+    {
+        return rate > 0;
+    }
+
+    /**
+     * @brief 这次清理是否需要核对
+     */
+    bool sample()
+    {
+        if (rate <= 0) {
+            return false;
+        }
+        credit += rate;
+        if (credit < 1) {
+            return false;
+        }
+        credit -= 1;
+        return true;
+    }
+
+    /**
+     * @brief 在优化路径之后运行全量遍历
+     * @param optimized 优化路径这次的结果
+     * @return 全量遍历的结果, removed 即为优化路径遗漏的跟踪者数
+     */
+    SweepResult verify(ServerMapDataManager *manager, int64_t uniqueId, const SweepResult &optimized)
+    {
+        auto result = sweepTrackers(manager, uniqueId);
+        verified++;
+        if (result.removed) {
+            mismatches++;
+            leftovers += result.removed;
+            lastMismatchId = uniqueId;
+            if (!optimized.sweeps) {
+                skippedMismatches++;
+            }
+        }
+        return result;
+    }
+
+    std::string report() const
+    {
+        auto line = fmt::format("shadow check: {:.1f}% sampled, {} verified, {} mismatches ({} after a skipped "
+                                "sweep), {} trackers left behind",
+                                rate * 100, verified, mismatches, skippedMismatches, leftovers);
+        if (mismatches) {
+            line += fmt::format(", last for UniqueID {}", lastMismatchId);
+        }
+        return line;
+    }
+};
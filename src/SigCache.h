@@ -0,0 +1,52 @@
+#pragma once
+#include "PeImage.h"
+#include "SigPattern.h"
+
+#include <cstring>
+
+/**
+ * @brief 离线工具 tools/SigResolver 预先算好的特征码地址 (相对模块基址)
+ */
+struct SigCacheEntry {
+    const char *pattern;
+    uint32_t rva;
+};
+
+// 在 CI 中对目标 bedrock_server.exe 运行 SigResolver 生成这个文件, 没有时退回到全模块扫描
+#if __has_include("SigCache.generated.h")
+#include "SigCache.generated.h"
+#else
+inline constexpr PeBuildId sigCacheBuildId{};
+inline constexpr SigCacheEntry sigCacheEntries[] = {
+    {nullptr, 0}
+};
+#endif
+
+/**
+ * @brief 从预生成的表中查找特征码地址
+ * 只有模块的构建信息与生成时一致, 且该地址处的字节确实匹配特征码时才使用
+ * @param imageBase 模块基址
+ * @param imageSize 模块大小
+ * @return 找到的地址, 否则返回 0
+ */
+inline uintptr_t sigCacheLookup(uintptr_t imageBase, size_t imageSize, const char *pattern)
+{
+    static const bool sameBuild = [&] {
+        PeInfo info;
+        return sigCacheBuildId.sizeOfImage != 0 && parsePe((const uint8_t *)imageBase, imageSize, info)
+            && info.buildId == sigCacheBuildId;
+    }();
+    if (!sameBuild) {
+        return 0;
+    }
+    for (auto &entry : sigCacheEntries) {
+        if (!entry.pattern || std::strcmp(entry.pattern, pattern) != 0) {
+            continue;
+        }
+        SigPattern sig(pattern);
+        if (entry.rva + sig.size() <= imageSize && sig.matchAt((const uint8_t *)imageBase + entry.rva)) {
+            return imageBase + entry.rva;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,271 @@
+#pragma once
+#include "SigPattern.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+/**
+ * @brief 代码段的 4 字节 n-gram 索引
+ * 每隔 stride 个位置记录一次, 按 (前两字节分桶, 桶内按完整 4 字节与位置排序) 存放
+ * 查找时在特征码的非通配段中选候选最少的一段作为锚点, 对 stride 种对齐分别二分出候选位置, 再逐个校验完整特征码
+ * 位置表直接向系统申请页面, 不占用进程堆, 用完后 release 归还
+ */
+class SigIndex {
+public:
+    static constexpr size_t gram = 4;
+    static constexpr size_t stride = 4;
+    /**
+     * @brief 能使用索引的特征码, 其最长非通配段至少要有这么长
+     */
+    static constexpr size_t minAnchor = gram + stride - 1;
+    static constexpr size_t bucketCount = 1 << 16;
+    /**
+     * @brief 候选数量超过 代码长度 / maxCandidateRatio 时放弃索引
+     */
+    static constexpr size_t maxCandidateRatio = 64;
+
+private:
+    const uint8_t *base = nullptr;
+    size_t length = 0;
+    /**
+     * @brief [0, bucketCount] 为各桶的起点, 其后为所有被索引的位置 (相对 base)
+     */
+    uint32_t *table = nullptr;
+    size_t tableBytes = 0;
+
+    static uint32_t gramAt(const uint8_t *p)
+    {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    static void *allocatePages(size_t bytes)
+    {
+#ifdef _WIN32
+        return VirtualAlloc(nullptr, bytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+        void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return p == MAP_FAILED ? nullptr : p;
+#endif
+    }
+
+    static void freePages(void *p, size_t bytes)
+    {
+#ifdef _WIN32
+        (void)bytes;
+        VirtualFree(p, 0, MEM_RELEASE);
+#else
+        munmap(p, bytes);
+#endif
+    }
+
+    template <typename F>
+    static void parallelFor(unsigned threads, F &&f)
+    {
+        std::vector<std::thread> workers;
+        for (unsigned t = 1; t < threads; t++) {
+            workers.emplace_back([&f, t] { f(t); });
+        }
+        f(0);
+        for (auto &worker : workers) {
+            worker.join();
+        }
+    }
+
+public:
+    SigIndex() = default;
+    SigIndex(const SigIndex &) = delete;
+    SigIndex &operator=(const SigIndex &) = delete;
+    ~SigIndex()
+    {
+        release();
+    }
+
+    bool ready() const
+    {
+        return table != nullptr;
+    }
+
+    size_t memoryBytes() const
+    {
+        return tableBytes;
+    }
+
+    /**
+     * @brief 为 [begin, end) 建立索引
+     * @param threads 使用的线程数, 0 表示按 CPU 核数
+     */
+    bool build(const uint8_t *begin, const uint8_t *end, unsigned threads = 0)
+    {
+        release();
+        size_t size = end > begin ? (size_t)(end - begin) : 0;
+        if (size < gram || size > UINT32_MAX) {
+            return false;
+        }
+        size_t count = (size - gram) / stride + 1;
+        if (!threads) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads = std::min(threads, 32u);
+
+        size_t bytes = (bucketCount + 1 + count) * sizeof(uint32_t);
+        auto pages = (uint32_t *)allocatePages(bytes);
+        if (!pages) {
+            return false;
+        }
+        uint32_t *starts = pages;
+        uint32_t *slots = pages + bucketCount + 1;
+        size_t chunk = (count + threads - 1) / threads;
+
+        // 每个线程统计自己那一段中各个桶的数量
+        std::vector<std::vector<uint32_t>> cursor(threads, std::vector<uint32_t>(bucketCount));
+        parallelFor(threads, [&](unsigned t) {
+            auto &counts = cursor[t];
+            for (size_t i = t * chunk, last = std::min(count, (t + 1) * chunk); i < last; i++) {
+                counts[gramAt(begin + i * stride) & 0xFFFF]++;
+            }
+        });
+
+        // 桶的起点, 以及每个线程在每个桶里的写入位置; 线程按顺序排列, 桶内位置天然递增
+        uint32_t total = 0;
+        for (size_t b = 0; b < bucketCount; b++) {
+            starts[b] = total;
+            for (unsigned t = 0; t < threads; t++) {
+                uint32_t c = cursor[t][b];
+                cursor[t][b] = total;
+                total += c;
+            }
+        }
+        starts[bucketCount] = total;
+
+        parallelFor(threads, [&](unsigned t) {
+            auto &next = cursor[t];
+            for (size_t i = t * chunk, last = std::min(count, (t + 1) * chunk); i < last; i++) {
+                slots[next[gramAt(begin + i * stride) & 0xFFFF]++] = (uint32_t)(i * stride);
+            }
+        });
+
+        // 桶内按完整的 4 字节排序, 相同时保持位置顺序
+        std::atomic<size_t> nextBucket{0};
+        parallelFor(threads, [&](unsigned) {
+            constexpr size_t batch = 256;
+            for (size_t first; (first = nextBucket.fetch_add(batch)) < bucketCount;) {
+                for (size_t b = first; b < first + batch; b++) {
+                    std::stable_sort(slots + starts[b], slots + starts[b + 1], [begin](uint32_t x, uint32_t y) {
+                        return gramAt(begin + x) < gramAt(begin + y);
+                    });
+                }
+            }
+        });
+
+        base = begin;
+        length = size;
+        table = pages;
+        tableBytes = bytes;
+        return true;
+    }
+
+    void release()
+    {
+        if (table) {
+            freePages(table, tableBytes);
+        }
+        table = nullptr;
+        tableBytes = 0;
+        base = nullptr;
+        length = 0;
+    }
+
+    /**
+     * @brief 用索引查找特征码的第一个匹配
+     * @param result 输出匹配地址, 没有匹配时为 nullptr
+     * @param checked 输出校验过的候选位置数量
+     * @return 索引未建立, 特征码中没有足够长的非通配段或锚点过于常见时返回 false, 此时应退回到线性扫描
+     */
+    bool find(const SigPattern &pattern, const uint8_t *&result, size_t *checked = nullptr) const
+    {
+        if (!ready()) {
+            return false;
+        }
+        // 在所有可用的锚点中选候选最少的 (最少见的字节组合)
+        size_t best = SIZE_MAX;
+        size_t anchor = 0;
+        for (size_t a = 0, run = 0; a < pattern.size(); a++) {
+            run = pattern.fixedAt(a) ? run + 1 : 0;
+            if (run < minAnchor) {
+                continue;
+            }
+            size_t start = a + 1 - minAnchor;
+            size_t cost = 0;
+            for (size_t s = 0; s < stride && cost < best; s++) {
+                auto [lower, upper] = lookup(gramAt(pattern.data() + start + s));
+                cost += (size_t)(upper - lower);
+            }
+            if (cost < best) {
+                best = cost;
+                anchor = start;
+            }
+        }
+        // 锚点太常见 (如一长串 00) 时候选太多, 排序校验反而比线性扫描慢
+        if (best == SIZE_MAX || best > length / maxCandidateRatio) {
+            return false;
+        }
+
+        // 匹配起点为 m 时, 恰好有一个 s 使 m + anchor + s 是被索引的位置
+        std::vector<size_t> candidates;
+        candidates.reserve(best);
+        for (size_t s = 0; s < stride; s++) {
+            auto [lower, upper] = lookup(gramAt(pattern.data() + anchor + s));
+            for (auto it = lower; it != upper; ++it) {
+                if (*it >= anchor + s) {
+                    candidates.push_back(*it - anchor - s);
+                }
+            }
+        }
+
+        // 按地址顺序校验, 与线性扫描返回同一个 (第一个) 匹配
+        std::sort(candidates.begin(), candidates.end());
+        result = nullptr;
+        size_t count = 0;
+        for (size_t m : candidates) {
+            if (m + pattern.size() > length) {
+                break;
+            }
+            count++;
+            if (pattern.matchAt(base + m)) {
+                result = base + m;
+                break;
+            }
+        }
+        if (checked) {
+            *checked = count;
+        }
+        return true;
+    }
+
+private:
+    /**
+     * @brief 二分出 4 字节为 key 的所有被索引位置
+     */
+    std::pair<const uint32_t *, const uint32_t *> lookup(uint32_t key) const
+    {
+        const uint32_t *slots = table + bucketCount + 1;
+        auto first = slots + table[key & 0xFFFF];
+        auto last = slots + table[(key & 0xFFFF) + 1];
+        auto lower = std::partition_point(first, last, [&](uint32_t pos) { return gramAt(base + pos) < key; });
+        auto upper = std::partition_point(lower, last, [&](uint32_t pos) { return gramAt(base + pos) == key; });
+        return {lower, upper};
+    }
+};
@@ -0,0 +1,130 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief 解析好的特征码, 每个 ? 表示一个通配字节 (?? 是两个), 与原来的逐字节循环相同
+ * 查找时使用 Horspool 跳表, 匹配失败时一次可跳过多个字节
+ */
+class SigPattern {
+    /**
+     * @brief 特征码字节, 通配位置的值无意义
+     */
+    std::vector<uint8_t> bytes;
+    /**
+     * @brief 每个位置是否需要比较 (0 表示通配符)
+     */
+    std::vector<uint8_t> fixed;
+    /**
+     * @brief Horspool 跳表: 窗口最后一个字节为 c 时窗口可右移的距离
+     */
+    std::array<size_t, 256> shift{};
+
+    static int hexValue(char c)
+    {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        c = (char)(c & ~0x20);
+        if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 0xa;
+        }
+        return 0;
+    }
+
+public:
+    SigPattern() = default;
+    explicit SigPattern(const char *signature)
+    {
+        for (const char *p = signature; *p;) {
+            if (*p == ' ') {
+                p++;
+                continue;
+            }
+            if (*p == '?') {
+                p++;
+                bytes.push_back(0);
+                fixed.push_back(0);
+                continue;
+            }
+            bytes.push_back((uint8_t)(hexValue(p[0]) << 4 | (p[1] ? hexValue(p[1]) : 0)));
+            fixed.push_back(1);
+            p += p[1] ? 2 : 1;
+        }
+
+        // 通配符能匹配任意字节, 所以最后一个通配符(不含末位)限制了所有字节的最大跳跃距离
+        size_t m = bytes.size();
+        size_t base = m;
+        for (size_t i = 0; i + 1 < m; i++) {
+            if (!fixed[i]) {
+                base = m - 1 - i;
+            }
+        }
+        shift.fill(base);
+        for (size_t i = 0; i + 1 < m; i++) {
+            if (fixed[i] && m - 1 - i < shift[bytes[i]]) {
+                shift[bytes[i]] = m - 1 - i;
+            }
+        }
+    }
+
+    size_t size() const
+    {
+        return bytes.size();
+    }
+
+    bool empty() const
+    {
+        return bytes.empty();
+    }
+
+    const uint8_t *data() const
+    {
+        return bytes.data();
+    }
+
+    /**
+     * @brief 第 i 个字节是否需要比较 (不是通配符)
+     */
+    bool fixedAt(size_t i) const
+    {
+        return fixed[i] != 0;
+    }
+
+    /**
+     * @brief 检查 p 处是否与特征码完全匹配 (调用者保证 p 之后至少有 size() 个字节可读)
+     */
+    bool matchAt(const uint8_t *p) const
+    {
+        for (size_t j = bytes.size(); j-- > 0;) {
+            if (fixed[j] && p[j] != bytes[j]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief 在 [begin, end) 中寻找第一个完整落在范围内的匹配
+     * @return 匹配的起始地址, 没找到返回 nullptr
+     */
+    const uint8_t *find(const uint8_t *begin, const uint8_t *end) const
+    {
+        size_t m = bytes.size();
+        if (m == 0) {
+            return begin;
+        }
+        if (end < begin || (size_t)(end - begin) < m) {
+            return nullptr;
+        }
+        size_t last = (size_t)(end - begin) - m;
+        for (size_t i = 0; i <= last; i += shift[begin[i + m - 1]]) {
+            if (matchAt(begin + i)) {
+                return begin + i;
+            }
+        }
+        return nullptr;
+    }
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+/**
+ * @brief 一个需要查找的函数的特征码
+ */
+struct SigDef {
+    const char *name;
+    /**
+     * @brief 内置特征码, 为 nullptr 时只能通过 config.json 的 signatures 提供
+     */
+    const char *pattern;
+};
+
+/**
+ * @brief 插件用到的所有特征码, 插件本身和离线工具 tools/SigResolver 共用这张表
+ */
+namespace Sigs {
+inline constexpr SigDef onPlayerLeft{
+    "ServerNetworkHandler::_onPlayerLeft",
+    "48 85 D2 0F 84 ? ? ? ? 48 89 5C 24 ? 55 56 57 41 54 41 55 41 56 41 57 48 8D AC 24 ? ? ? ? 48 81 EC 70 02 00 00"};
+inline constexpr SigDef getOrCreateUniqueID{"Actor::getOrCreateUniqueID",
+                                            "40 53 48 83 EC 30 4C 8B 51 ? BB 1A 48 1E A5"};
+inline constexpr SigDef getMapDataManager{"ServerLevel::_getMapDataManager",
+                                          "48 83 EC 28 48 8B 81 C8 12 00 00 48 85 C0 74 05"};
+
+inline constexpr SigDef addTrackedMapEntity{"MapItemSavedData::addTrackedMapEntity", nullptr};
+inline constexpr SigDef actorRemove{"Actor::remove", nullptr};
+inline constexpr SigDef itemFrameRemoved{"ItemFrameBlockActor::onRemoved", nullptr};
+inline constexpr SigDef nextUpdatePacket{"MapItemTrackedActor::nextUpdatePacket", nullptr};
+inline constexpr SigDef getUpdatePacket{"MapItemSavedData::getUpdatePacket", nullptr};
+
+inline constexpr SigDef all[] = {onPlayerLeft,     getOrCreateUniqueID, getMapDataManager, addTrackedMapEntity,
+                                 actorRemove,      itemFrameRemoved,    nextUpdatePacket,  getUpdatePacket};
+} // namespace Sigs
@@ -0,0 +1,129 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <fmt/format.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 记录插件加载期间每次特征码查找和每个Hook安装的耗时
+ * 特征码查找在后台线程进行, 所以记录时加锁
+ */
+class StartupProfiler {
+public:
+    /**
+     * @brief 一次特征码查找, 同一个 SignCode 的备用特征码各算一次, attempt 即当时的 findCount
+     */
+    struct SigAttempt {
+        std::string title;
+        int attempt;
+        double ms;
+        size_t bytesScanned;
+        bool cacheHit;
+        bool indexed;
+        bool found;
+    };
+
+    /**
+     * @brief 加载期间其它的准备工作, 如建立特征码索引
+     */
+    struct Stage {
+        std::string name;
+        double ms;
+        std::string detail;
+    };
+
+    struct HookTiming {
+        std::string name;
+        double addMs;
+        double enableMs;
+        bool ok;
+    };
+
+private:
+    mutable std::mutex mutex;
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    std::vector<SigAttempt> attempts;
+    std::vector<HookTiming> hooks;
+    std::vector<Stage> stages;
+
+public:
+    /**
+     * @brief 插件开始加载时调用, 汇总中的总耗时从这里算起
+     */
+    void start()
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        begin = std::chrono::steady_clock::now();
+    }
+
+    void recordSignature(SigAttempt attempt)
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        attempts.push_back(std::move(attempt));
+    }
+
+    void recordStage(Stage stage)
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        stages.push_back(std::move(stage));
+    }
+
+    void recordHook(HookTiming hook)
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        hooks.push_back(std::move(hook));
+    }
+
+    /**
+     * @brief 生成汇总表, 每个元素为一行
+     */
+    std::vector<std::string> report() const
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        double sigMs = 0;
+        double hookMs = 0;
+        size_t scanned = 0;
+        for (auto &a : attempts) {
+            sigMs += a.ms;
+            scanned += a.bytesScanned;
+        }
+        for (auto &h : hooks) {
+            hookMs += h.addMs + h.enableMs;
+        }
+
+        std::vector<std::string> lines;
+        lines.push_back(fmt::format("startup: {:.1f} ms since load, signatures {:.1f} ms ({} attempts, {:.1f} MiB "
+                                    "scanned), hooks {:.2f} ms ({} installed)",
+                                    totalMs, sigMs, attempts.size(), (double)scanned / (1 << 20), hookMs,
+                                    hooks.size()));
+        for (auto &s : stages) {
+            lines.push_back(fmt::format("  {:<40} {:>14.2f} ms  {}", s.name, s.ms, s.detail));
+        }
+        lines.push_back(fmt::format("  {:<40} {:>3} {:>10} {:>12} {}", "signature", "try", "ms", "scanned KiB",
+                                    "result"));
+        for (auto &a : attempts) {
+            lines.push_back(fmt::format("  {:<40} {:>3} {:>10.2f} {:>12} {}", a.title, a.attempt, a.ms,
+                                        a.bytesScanned / 1024,
+                                        a.cacheHit ? "cached"
+                                        : a.found  ? (a.indexed ? "found (index)" : "found")
+                                                   : (a.indexed ? "missing (index)" : "missing")));
+        }
+        if (!hooks.empty()) {
+            lines.push_back(fmt::format("  {:<40} {:>10} {:>10} {}", "hook", "add ms", "enable ms", "result"));
+            for (auto &h : hooks) {
+                lines.push_back(fmt::format("  {:<40} {:>10.3f} {:>10.3f} {}", h.name, h.addMs, h.enableMs,
+                                            h.ok ? "ok" : "failed"));
+            }
+        }
+        return lines;
+    }
+};
+
+inline StartupProfiler &startupProfiler()
+{
+    static StartupProfiler profiler;
+    return profiler;
+}
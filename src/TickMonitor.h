@@ -0,0 +1,201 @@
+#pragma once
+#include "MapCleanup.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fmt/format.h>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 统计每个服务器 tick 的耗时, 以及其中地图清理占用的时间
+ * onTick 每个 tick 在服务器线程调用一次, 两次调用的间隔即为一个 tick 的耗时
+ * (服务器空闲时会睡眠补足 50ms, 所以只有真正超时的 tick 间隔才会明显大于预算)
+ * 只有清理规则的遍历 (runCleanup) 计为清理; 过滤器重建, 核对, 跟踪者上限等维护工作单独统计, 不算在清理头上
+ * addCleanup / addMaintenance 可以从任意线程调用, 当前 tick 的累计值是原子的, 由 onTick 取走清零
+ */
+class TickMonitor {
+public:
+    /**
+     * @brief 清理导致超时的 tick 信息, 用于输出警告
+     */
+    struct Overrun {
+        double tickMs;
+        double cleanupMs;
+        size_t sweeps;
+        size_t maps;
+        size_t trackers;
+        size_t removed;
+    };
+
+private:
+    static constexpr size_t bucketCount = 24;
+
+    std::chrono::steady_clock::time_point lastTick{};
+    double budgetMs = 50;
+    /**
+     * @brief 未启用时 addCleanup 不做任何事, 否则没有 onTick 取走, 累计值会一直增长
+     */
+    std::atomic<bool> enabled{false};
+
+    // 当前 tick 内的清理
+    std::atomic<int64_t> cleanupNs{0};
+    std::atomic<int64_t> maintenanceNs{0};
+    std::atomic<size_t> sweeps{0};
+    std::atomic<size_t> sweptMaps{0};
+    std::atomic<size_t> sweptTrackers{0};
+    std::atomic<size_t> sweptRemoved{0};
+
+    uint64_t ticks = 0;
+    uint64_t cleanupTicks = 0;
+    uint64_t overruns = 0;
+    uint64_t cleanupOverruns = 0;
+    uint64_t maintenanceTicks = 0;
+    uint64_t maintenanceOverruns = 0;
+    double totalMaintenanceUs = 0;
+    double maxCleanupUs = 0;
+    double totalCleanupUs = 0;
+    /**
+     * @brief 有清理的 tick 中清理耗时的分布, 第 i 个桶为 [2^i, 2^(i+1)) 微秒
+     */
+    std::array<uint64_t, bucketCount> histogram{};
+
+    static size_t bucketOf(double us)
+    {
+        size_t bucket = 0;
+        while (bucket + 1 < bucketCount && us >= (double)(2ull << bucket)) {
+            bucket++;
+        }
+        return bucket;
+    }
+
+    double percentile(double p) const
+    {
+        uint64_t target = (uint64_t)(p * (double)cleanupTicks);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < bucketCount; i++) {
+            seen += histogram[i];
+            if (seen > target) {
+                return (double)(2ull << i);
+            }
+        }
+        return maxCleanupUs;
+    }
+
+public:
+    void setBudget(double ms)
+    {
+        budgetMs = ms;
+    }
+
+    /**
+     * @brief 启用后才会累计清理耗时, 启用时 onTick 必须每个 tick 调用
+     */
+    void setEnabled(bool on)
+    {
+        enabled = on;
+    }
+
+    /**
+     * @brief 记录一次清理, 计入下一次 onTick 所结束的 tick, 未启用时忽略
+     */
+    void addCleanup(std::chrono::steady_clock::duration duration, const SweepResult &result)
+    {
+        if (!enabled.load(std::memory_order_relaxed)) {
+            return;
+        }
+        cleanupNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(),
+                            std::memory_order_relaxed);
+        sweeps.fetch_add(1, std::memory_order_relaxed);
+        sweptMaps.fetch_add(result.maps, std::memory_order_relaxed);
+        sweptTrackers.fetch_add(result.trackers, std::memory_order_relaxed);
+        sweptRemoved.fetch_add(result.removed, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 记录一次与清理无关的维护工作, 只统计耗时, 未启用时忽略
+     */
+    void addMaintenance(std::chrono::steady_clock::duration duration)
+    {
+        if (!enabled.load(std::memory_order_relaxed)) {
+            return;
+        }
+        maintenanceNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(),
+                                std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 结束当前 tick
+     * @return 若该 tick 超出预算且去掉清理耗时后不会超出, 返回超时信息
+     */
+    std::optional<Overrun> onTick()
+    {
+        auto now = std::chrono::steady_clock::now();
+        std::optional<Overrun> result;
+        // 取走本 tick 的累计值, 之后的 addCleanup 计入下一个 tick
+        double cleanupUs = (double)cleanupNs.exchange(0, std::memory_order_relaxed) / 1000;
+        double maintenanceUs = (double)maintenanceNs.exchange(0, std::memory_order_relaxed) / 1000;
+        size_t sweepCount = sweeps.exchange(0, std::memory_order_relaxed);
+        size_t maps = sweptMaps.exchange(0, std::memory_order_relaxed);
+        size_t trackers = sweptTrackers.exchange(0, std::memory_order_relaxed);
+        size_t removed = sweptRemoved.exchange(0, std::memory_order_relaxed);
+        if (lastTick != std::chrono::steady_clock::time_point{}) {
+            double tickMs = std::chrono::duration<double, std::milli>(now - lastTick).count();
+            ticks++;
+            bool overrun = tickMs > budgetMs;
+            overruns += overrun;
+            if (sweepCount) {
+                cleanupTicks++;
+                totalCleanupUs += cleanupUs;
+                maxCleanupUs = std::max(maxCleanupUs, cleanupUs);
+                histogram[bucketOf(cleanupUs)]++;
+                if (overrun && tickMs - cleanupUs / 1000 <= budgetMs) {
+                    cleanupOverruns++;
+                    result = Overrun{tickMs, cleanupUs / 1000, sweepCount, maps, trackers, removed};
+                }
+            }
+            if (maintenanceUs > 0) {
+                maintenanceTicks++;
+                totalMaintenanceUs += maintenanceUs;
+                if (overrun && !result && tickMs - maintenanceUs / 1000 <= budgetMs) {
+                    maintenanceOverruns++;
+                }
+            }
+        }
+        lastTick = now;
+        return result;
+    }
+
+    /**
+     * @brief 生成统计报告, 每个元素为一行
+     */
+    std::vector<std::string> report() const
+    {
+        std::vector<std::string> lines;
+        lines.push_back(fmt::format("ticks: {}, over {:.0f} ms budget: {}, caused by cleanup: {}, by maintenance: {}",
+                                    ticks, budgetMs, overruns, cleanupOverruns, maintenanceOverruns));
+        if (maintenanceTicks) {
+            lines.push_back(fmt::format("ticks with maintenance: {}, mean {:.1f} us", maintenanceTicks,
+                                        totalMaintenanceUs / (double)maintenanceTicks));
+        }
+        if (!cleanupTicks) {
+            lines.push_back("no cleanup has run yet");
+            return lines;
+        }
+        lines.push_back(fmt::format("ticks with cleanup: {}, mean {:.1f} us, p50 < {:.0f} us, p99 < {:.0f} us, "
+                                    "max {:.1f} us",
+                                    cleanupTicks, totalCleanupUs / (double)cleanupTicks, percentile(0.5),
+                                    percentile(0.99), maxCleanupUs));
+        for (size_t i = 0; i < bucketCount; i++) {
+            if (histogram[i]) {
+                lines.push_back(fmt::format("  {:>8} - {:>8} us: {}", i == 0 ? 0ull : 1ull << i, 2ull << i,
+                                            histogram[i]));
+            }
+        }
+        return lines;
+    }
+};
@@ -0,0 +1,108 @@
+#pragma once
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief 玩家进出与地图跟踪事件的记录格式, 由插件录制, tools/TraceReplay 回放
+ * 每行一个事件: <微秒时间戳> <类型> <UniqueID> [地图]
+ * 地图用 MapItemSavedData 的地址标识, 只在同一次录制内有意义
+ */
+enum class TraceEvent : char {
+    Join = 'J',
+    Leave = 'L',
+    TrackerAdd = 'T',
+    /**
+     * @brief 插件移除了某张地图上跟踪该实体的跟踪者 (实体移除, 展示框破坏, 切换维度, 数量上限)
+     * 玩家离开引起的移除不录制, 回放时由被测的清理策略自己完成
+     */
+    TrackerRemove = 'R',
+};
+
+struct TraceRecord {
+    int64_t timeUs = 0;
+    TraceEvent type = TraceEvent::Join;
+    int64_t uniqueId = 0;
+    uint64_t mapKey = 0;
+};
+
+inline constexpr const char *traceHeader = "# ChunkLeakFix trace v2";
+
+/**
+ * @brief 解析一行记录, 注释行和格式错误的行返回 false
+ */
+inline bool parseTraceRecord(const std::string &line, TraceRecord &record)
+{
+    char type = 0;
+    unsigned long long mapKey = 0;
+    long long timeUs = 0;
+    long long uniqueId = 0;
+    int n = std::sscanf(line.c_str(), "%lld %c %lld %llx", &timeUs, &type, &uniqueId, &mapKey);
+    bool hasMap = type == 'T' || type == 'R';
+    if (n < 3 || (type != 'J' && type != 'L' && !hasMap) || (hasMap && n < 4)) {
+        return false;
+    }
+    record.timeUs = timeUs;
+    record.type = (TraceEvent)type;
+    record.uniqueId = uniqueId;
+    record.mapKey = mapKey;
+    return true;
+}
+
+/**
+ * @brief 把事件追加写入 trace 文件, 可以从任意线程调用
+ */
+class TraceRecorder {
+    std::mutex mutex;
+    std::ofstream out;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    bool open(const std::filesystem::path &path)
+    {
+        std::lock_guard lock(mutex);
+        out.open(path, std::ios::out | std::ios::trunc);
+        start = std::chrono::steady_clock::now();
+        if (out) {
+            out << traceHeader << '\n';
+        }
+        return (bool)out;
+    }
+
+    bool isOpen() const
+    {
+        return out.is_open();
+    }
+
+    void record(TraceEvent type, int64_t uniqueId, uint64_t mapKey = 0)
+    {
+        std::lock_guard lock(mutex);
+        if (!out.is_open()) {
+            return;
+        }
+        auto timeUs =
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        char line[96];
+        if (type == TraceEvent::TrackerAdd || type == TraceEvent::TrackerRemove) {
+            std::snprintf(line, sizeof(line), "%lld %c %" PRId64 " %" PRIx64 "\n", (long long)timeUs, (char)type,
+                          uniqueId, mapKey);
+        }
+        else {
+            std::snprintf(line, sizeof(line), "%lld %c %" PRId64 "\n", (long long)timeUs, (char)type, uniqueId);
+        }
+        out << line;
+    }
+
+    void close()
+    {
+        std::lock_guard lock(mutex);
+        if (out.is_open()) {
+            out.close();
+        }
+    }
+};
@@ -0,0 +1,187 @@
+#pragma once
+#include "MapData.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 每张地图跟踪者数量的软上限: 超出时移除最久没有更新的可移除跟踪者
+ * 只移除实体已经不在 (玩家离线) 或已不再持有地图的实体跟踪者, 持有地图的在线玩家和物品展示框不受影响,
+ * 所以这不是硬上限, 活跃的跟踪者较多时地图会一直超出, 超出的次数见报告
+ * 跟踪者每次生成更新包时按 (地图, 跟踪的 UniqueID) 记录当前 tick, 新增时也算一次更新
+ * 新增跟踪者时只记下超出上限的地图, 在 tick 任务中再移除, 不在服务端遍历跟踪列表的过程中修改它
+ * 所有方法都在服务器线程调用
+ */
+class TrackerCap {
+    /**
+     * @brief 一张地图上的一个实体跟踪者, 跟踪者对象被服务端重建或地址被复用时不会错配
+     */
+    struct StampKey {
+        const MapItemSavedData *map;
+        int64_t uniqueId;
+
+        bool operator==(const StampKey &) const = default;
+    };
+    struct StampKeyHash {
+        size_t operator()(const StampKey &key) const noexcept
+        {
+            return std::hash<const void *>()(key.map) ^ (std::hash<int64_t>()(key.uniqueId) * 0x9E3779B97F4A7C15ull);
+        }
+    };
+
+    size_t cap = 0;
+    uint64_t tick = 0;
+    std::unordered_map<StampKey, uint64_t, StampKeyHash> stamps;
+    std::unordered_set<const MapItemSavedData *> overCap;
+    uint64_t evicted = 0;
+    /**
+     * @brief 因为没有足够的可移除跟踪者而仍然超出上限的次数
+     */
+    uint64_t keptOverCap = 0;
+
+public:
+    /**
+     * @param maxTrackers 每张地图跟踪者数的软上限, 0 表示不限制
+     */
+    void configure(size_t maxTrackers)
+    {
+        cap = maxTrackers;
+    }
+
+    bool enabled() const
+    {
+        return cap > 0;
+    }
+
+    void onTick()
+    {
+        tick++;
+    }
+
+    /**
+     * @brief 是否有等待处理的超限地图
+     */
+    bool pending() const
+    {
+        return !overCap.empty();
+    }
+
+    void touch(const MapItemSavedData *data, const MapItemTrackedActor *tracker)
+    {
+        if (MapLayout::trackedType(tracker) == TrackedType::Entity) {
+            stamps[{data, MapLayout::trackedId(tracker)}] = tick;
+        }
+    }
+
+    void onAdded(const MapItemSavedData *data, const MapItemTrackedActor *tracker)
+    {
+        touch(data, tracker);
+        if (MapLayout::trackers(const_cast<MapItemSavedData *>(data)).size() > cap) {
+            overCap.insert(data);
+        }
+    }
+
+    /**
+     * @brief 移除超出上限的地图中最久没有更新的可移除跟踪者, 保持其余跟踪者的顺序
+     * @param holders 在线且持有地图的玩家, 他们的跟踪者不会被移除
+     * @param retire 被移除的跟踪者及其所在的地图交给它处理, 为 nullptr 时直接释放
+     * @return 移除的跟踪者数
+     */
+    size_t enforce(ServerMapDataManager *manager, const std::unordered_set<int64_t> &holders,
+                   void (*retire)(const MapItemSavedData *, std::shared_ptr<MapItemTrackedActor> &&) = nullptr)
+    {
+        if (overCap.empty()) {
+            return 0;
+        }
+        size_t removed = 0;
+        // 只处理仍然加载着的地图, 记下的地址可能已经失效
+        for (auto &[id, holder] : MapLayout::allMapData(manager)) {
+            if (!overCap.contains(holder.get())) {
+                continue;
+            }
+            auto &list = MapLayout::trackers(holder.get());
+            if (list.size() <= cap) {
+                continue;
+            }
+            size_t excess = list.size() - cap;
+            std::vector<std::pair<uint64_t, size_t>> order;
+            order.reserve(list.size());
+            for (size_t i = 0; i < list.size(); i++) {
+                auto tracker = list[i].get();
+                // 物品展示框是否还在无法从这里判断, 由展示框移除的规则负责
+                if (!tracker || MapLayout::trackedType(tracker) != TrackedType::Entity) {
+                    continue;
+                }
+                auto uniqueId = MapLayout::trackedId(tracker);
+                if (holders.contains(uniqueId)) {
+                    continue;
+                }
+                auto it = stamps.find({holder.get(), uniqueId});
+                order.emplace_back(it == stamps.end() ? 0 : it->second, i);
+            }
+            if (order.size() < excess) {
+                keptOverCap++;
+                excess = order.size();
+                if (!excess) {
+                    continue;
+                }
+            }
+            std::nth_element(order.begin(), order.begin() + (ptrdiff_t)(excess - 1), order.end());
+            std::vector<bool> evict(list.size());
+            for (size_t i = 0; i < excess; i++) {
+                evict[order[i].second] = true;
+            }
+            size_t kept = 0;
+            for (size_t i = 0; i < list.size(); i++) {
+                if (evict[i]) {
+                    stamps.erase({holder.get(), MapLayout::trackedId(list[i].get())});
+                    if (retire) {
+                        retire(holder.get(), std::move(list[i]));
+                    }
+                    else {
+                        list[i].reset();
+                    }
+                    continue;
+                }
+                if (kept != i) {
+                    list[kept] = std::move(list[i]);
+                }
+                kept++;
+            }
+            list.erase(list.begin() + (ptrdiff_t)kept, list.end());
+            removed += excess;
+        }
+        overCap.clear();
+        evicted += removed;
+        return removed;
+    }
+
+    /**
+     * @brief 丢弃已不在对应地图跟踪列表中的记录, 定期调用
+     */
+    void prune(ServerMapDataManager *manager)
+    {
+        std::unordered_set<StampKey, StampKeyHash> live;
+        for (auto &[id, holder] : MapLayout::allMapData(manager)) {
+            for (auto &tracker : MapLayout::trackers(holder.get())) {
+                if (tracker && MapLayout::trackedType(tracker.get()) == TrackedType::Entity) {
+                    live.insert({holder.get(), MapLayout::trackedId(tracker.get())});
+                }
+            }
+        }
+        std::erase_if(stamps, [&](const auto &item) { return !live.contains(item.first); });
+    }
+
+    std::string report() const
+    {
+        return "tracker soft cap: " + std::to_string(cap) + " per map, " + std::to_string(evicted) + " evicted, "
+             + std::to_string(keptOverCap) + " times left over the cap by active holders, "
+             + std::to_string(stamps.size()) + " trackers stamped";
+    }
+};
@@ -0,0 +1,128 @@
+#pragma once
+#include "BloomFilter.h"
+#include "MapCleanup.h"
+#include "MapData.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief 记录当前出现在任意地图跟踪列表中的 UniqueID
+ * 玩家离开时若过滤器确定其不在任何跟踪列表中, 就可以跳过全量遍历
+ * 跟踪者被移除时无法从布隆过滤器中删除, 需要定期从地图数据重建以控制误判率
+ */
+class TrackerFilter {
+    /**
+     * @brief 保护 filter 和 rebuildInserts; 重建在锁外遍历地图, 只在换入新过滤器时持锁
+     */
+    mutable std::mutex mutex;
+    BloomFilter filter;
+    /**
+     * @brief 重建期间新增的跟踪者, 换入新过滤器前补插进去, 避免遍历开始后新增的跟踪者被漏掉
+     */
+    std::vector<int64_t> rebuildInserts;
+    bool rebuilding = false;
+    /**
+     * @brief 插入Hook安装后完成过一次重建才启用, 否则可能漏掉 Hook 之前就存在的跟踪者
+     */
+    std::atomic<bool> armed{false};
+    std::atomic<bool> hookInstalled{false};
+    std::chrono::steady_clock::time_point lastRebuild{};
+
+public:
+    void configure(size_t bits, int hashes)
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        filter = BloomFilter(bits, hashes);
+        armed = false;
+    }
+
+    /**
+     * @brief 跟踪者插入Hook已安装, 下一次重建后启用过滤
+     */
+    void setHookInstalled()
+    {
+        hookInstalled = true;
+    }
+
+    bool isArmed() const
+    {
+        return armed;
+    }
+
+    void onTrackerAdded(int64_t uniqueId)
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        filter.insert((uint64_t)uniqueId);
+        if (rebuilding) {
+            rebuildInserts.push_back(uniqueId);
+        }
+    }
+
+    /**
+     * @brief 实体是否可能出现在某个跟踪列表中, 未启用时总是返回 true
+     */
+    bool mayTrack(int64_t uniqueId) const
+    {
+        if (!armed) {
+            return true;
+        }
+        std::lock_guard<std::mutex> guard(mutex);
+        return filter.mayContain((uint64_t)uniqueId);
+    }
+
+    /**
+     * @param interval 距上次重建的最长时间
+     * @param maxFalsePositiveRate 估算误判率超过此值时提前重建
+     */
+    bool needsRebuild(std::chrono::steady_clock::duration interval, double maxFalsePositiveRate) const
+    {
+        if (!hookInstalled) {
+            return false;
+        }
+        if (!armed || std::chrono::steady_clock::now() - lastRebuild >= interval) {
+            return true;
+        }
+        std::lock_guard<std::mutex> guard(mutex);
+        return filter.falsePositiveRate() > maxFalsePositiveRate;
+    }
+
+    /**
+     * @brief 在一个新的过滤器中从所有地图当前的跟踪列表重新填充, 完成后再整体换入
+     * 重建期间旧过滤器仍然有效, mayTrack 不会因为清空而误报"不存在"; 必须在服务器线程调用
+     * @return 遍历的地图数和跟踪者数
+     */
+    SweepResult rebuild(ServerMapDataManager *manager)
+    {
+        SweepResult result;
+        bool installed = hookInstalled;
+        BloomFilter fresh;
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            fresh = BloomFilter(filter.bits(), filter.hashes());
+            rebuilding = true;
+            rebuildInserts.clear();
+        }
+        for (auto &[id, data] : MapLayout::allMapData(manager)) {
+            result.maps++;
+            for (auto &tracker : MapLayout::trackers(data.get())) {
+                fresh.insert((uint64_t)MapLayout::trackedId(tracker.get()));
+                result.trackers++;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            for (auto uniqueId : rebuildInserts) {
+                fresh.insert((uint64_t)uniqueId);
+            }
+            rebuildInserts.clear();
+            rebuilding = false;
+            filter = std::move(fresh);
+        }
+        lastRebuild = std::chrono::steady_clock::now();
+        armed = installed;
+        return result;
+    }
+};
@@ -0,0 +1,126 @@
+#pragma once
+#include "MapData.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief 玩家距地图覆盖范围至少 distance 格时, 每 interval 个 tick 才更新一次
+ */
+struct ThrottleTier {
+    int distance;
+    int interval;
+};
+
+/**
+ * @brief 按玩家与地图的距离降低玩家收到地图更新的频率
+ * 在 MapItemSavedData::getUpdatePacket 中判断: 玩家没有跟踪者时它本来就返回空指针, 调用者必然会检查
+ * 被跳过的 tick 不调用原函数, 跟踪者的改动保留到下一次允许更新时一起发送
+ * 玩家位置由服务器线程定期刷新, allow 也只在服务器线程调用
+ */
+class UpdateThrottle {
+public:
+    struct Viewer {
+        double x;
+        double z;
+        /**
+         * @brief 主手拿着地图, 无法区分是哪一张, 所以对该玩家的所有地图都按手持处理
+         */
+        bool holdingMap;
+    };
+
+private:
+    /**
+     * @brief 按 distance 从小到大排列
+     */
+    std::vector<ThrottleTier> tiers;
+    int handInterval = 1;
+    std::unordered_map<int64_t, Viewer> viewers;
+    uint64_t tick = 0;
+    uint64_t allowed = 0;
+    uint64_t skipped = 0;
+
+public:
+    void configure(std::vector<ThrottleTier> list, int hand)
+    {
+        std::erase_if(list, [](const ThrottleTier &tier) { return tier.interval < 1; });
+        std::sort(list.begin(), list.end(),
+                  [](const ThrottleTier &a, const ThrottleTier &b) { return a.distance < b.distance; });
+        tiers = std::move(list);
+        handInterval = std::max(1, hand);
+    }
+
+    /**
+     * @brief 每个 tick 调用一次
+     */
+    void onTick()
+    {
+        tick++;
+    }
+
+    /**
+     * @brief 用当前在线玩家替换位置表, 不在表中的实体不限速
+     */
+    void setViewers(std::unordered_map<int64_t, Viewer> list)
+    {
+        viewers = std::move(list);
+    }
+
+    /**
+     * @brief 玩家与以 (centerX, centerZ) 为中心, 边长为 2 * halfSize 的地图范围之间的距离, 在范围内为 0
+     */
+    static double distanceOutside(const Viewer &viewer, int centerX, int centerZ, int halfSize)
+    {
+        double dx = std::abs(viewer.x - centerX) - halfSize;
+        double dz = std::abs(viewer.z - centerZ) - halfSize;
+        return std::max({0.0, dx, dz});
+    }
+
+    int intervalFor(double distance) const
+    {
+        int interval = 1;
+        for (auto &tier : tiers) {
+            if (distance < tier.distance) {
+                break;
+            }
+            interval = tier.interval;
+        }
+        return interval;
+    }
+
+    /**
+     * @brief 这个 tick 是否为该玩家生成这张地图的更新, 需要 mapOriginOffset 和 mapScaleOffset
+     */
+    bool allow(int64_t uniqueId, const MapItemSavedData *data)
+    {
+        int interval = 1;
+        if (auto it = viewers.find(uniqueId); it != viewers.end()) {
+            if (it->second.holdingMap) {
+                interval = handInterval;
+            }
+            else {
+                // 比例为 s 的地图覆盖 128 * 2^s 格
+                int halfSize = 64 << std::clamp<int>(MapLayout::mapScale(data), 0, 4);
+                auto &origin = MapLayout::mapOrigin(data);
+                interval = intervalFor(distanceOutside(it->second, origin.x, origin.z, halfSize));
+            }
+        }
+        // 用玩家和地图错开各自的更新时机, 避免同一个 tick 集中更新
+        if (interval > 1 && (tick + (uint64_t)uniqueId + ((uintptr_t)data >> 4)) % (uint64_t)interval != 0) {
+            skipped++;
+            return false;
+        }
+        allowed++;
+        return true;
+    }
+
+    std::string report() const
+    {
+        return "throttle: " + std::to_string(allowed) + " map updates sent, " + std::to_string(skipped)
+             + " skipped, " + std::to_string(viewers.size()) + " players tracked";
+    }
+};
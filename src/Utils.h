@@ -1,10 +1,23 @@
 #pragma once
+#include "Memory.h"
+#include "SigCache.h"
+#include "SigIndex.h"
+#include "SigPattern.h"
+#include "StartupProfiler.h"
+
+#ifdef _WIN32
 #include <windows.h>
 #include <Psapi.h>
 #include <Shlobj.h>
+#else
+#include <link.h>
+#define __fastcall
+#endif
+#include <chrono>
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <utility>
 
 #define INRANGE(x, a, b) (x >= a && x <= b)
 #define GET_BYTE(x)      (GET_BITS(x[0]) << 4 | GET_BITS(x[1]))
@@ -12,120 +25,144 @@
     (INRANGE((x & (~0x20)), 'A', 'F') ? ((x & (~0x20)) - 'A' + 0xa) : (INRANGE(x, '0', '9') ? x - '0' : 0))
 
 
-    template <class T>
-[[nodiscard]] constexpr T& dAccess(void* ptr, ptrdiff_t off) {
-    return *(T*)((uintptr_t)((uintptr_t)ptr + off));
-}
-
-template <class T>
-[[nodiscard]] constexpr T const& dAccess(void const* ptr, ptrdiff_t off) {
-    return *(T*)((uintptr_t)((uintptr_t)ptr + off));
-}
-
+/**
+ * @brief 一次 findSig 的开销, 供启动分析使用
+ */
+struct FindSigStats {
+    size_t bytesScanned = 0;
+    bool cacheHit = false;
+    /**
+     * @brief 是否由 n-gram 索引得出结果, 此时 bytesScanned 为校验候选位置比较的字节数
+     */
+    bool indexed = false;
+};
 
-// 使用特征码查找地址
-auto findSig(const char *szSignature) -> uintptr_t
+/**
+ * @brief findSig 的查找范围: Windows 下为整个主模块, Linux 下为主程序的可执行段
+ */
+inline std::pair<uintptr_t, uintptr_t> sigSearchRange()
 {
-    const char *pattern = szSignature;
-    uintptr_t firstMatch = 0;
+#ifndef _WIN32
+    // 各段之间可能有未映射的空隙, 只取代码所在的段
+    static const auto range = [] {
+        std::pair<uintptr_t, uintptr_t> text{};
+        dl_iterate_phdr(
+            [](dl_phdr_info *info, size_t, void *data) {
+                auto out = (std::pair<uintptr_t, uintptr_t> *)data;
+                for (int i = 0; i < info->dlpi_phnum; i++) {
+                    auto &phdr = info->dlpi_phdr[i];
+                    if (phdr.p_type == PT_LOAD && (phdr.p_flags & PF_X)) {
+                        *out = {info->dlpi_addr + phdr.p_vaddr, info->dlpi_addr + phdr.p_vaddr + phdr.p_memsz};
+                        break;
+                    }
+                }
+                // 第一个模块就是主程序
+                return 1;
+            },
+            &text);
+        return text;
+    }();
+#else
+    static const auto range = [] {
 #ifndef INCLIENT
-    static const auto rangeStart = (uintptr_t)GetModuleHandleA("bedrock_server.exe");
+        auto rangeStart = (uintptr_t)GetModuleHandleA("bedrock_server.exe");
 #else
-    static const auto rangeStart = (uintptr_t)GetModuleHandleA("Minecraft.Windows.exe");
+        auto rangeStart = (uintptr_t)GetModuleHandleA("Minecraft.Windows.exe");
 #endif
-    static MODULEINFO miModInfo;
-    static bool init = false;
-
-    if (!init) {
-        init = true;
+        MODULEINFO miModInfo{};
         GetModuleInformation(GetCurrentProcess(), (HMODULE)rangeStart, &miModInfo, sizeof(MODULEINFO));
-    }
-
-    static const uintptr_t rangeEnd = rangeStart + miModInfo.SizeOfImage;
-
-    BYTE patByte = GET_BYTE(pattern);
-    const char *oldPat = pattern;
-
-    for (uintptr_t pCur = rangeStart; pCur < rangeEnd; pCur++) {
-        if (!*pattern) {
-            return firstMatch;
-        }
+        return std::pair<uintptr_t, uintptr_t>{rangeStart, rangeStart + miModInfo.SizeOfImage};
+    }();
+#endif // !_WIN32
+    return range;
+}
 
-        while (*(PBYTE)pattern == ' ') {
-            pattern++;
-        }
+/**
+ * @brief 查找范围的 n-gram 索引, 只在加载期间按配置建立, 特征码解析完后释放
+ */
+inline SigIndex &sigIndex()
+{
+    static SigIndex index;
+    return index;
+}
 
-        if (!*pattern) {
-            return firstMatch;
-        }
+/**
+ * @brief 为 findSig 的查找范围建立索引, 耗时记入启动分析
+ */
+inline bool buildSigIndex()
+{
+    auto [begin, end] = sigSearchRange();
+    auto t0 = std::chrono::steady_clock::now();
+    bool ok = sigIndex().build((const uint8_t *)begin, (const uint8_t *)end);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    startupProfiler().recordStage({"signature index", ms,
+                                   ok ? fmt::format("{:.1f} MiB code, {:.1f} MiB index", (double)(end - begin) / (1 << 20),
+                                                    (double)sigIndex().memoryBytes() / (1 << 20))
+                                      : std::string("failed")});
+    return ok;
+}
 
-        if (oldPat != pattern) {
-            oldPat = pattern;
-            if (*(PBYTE)pattern != '\?') {
-                patByte = GET_BYTE(pattern);
-            }
+/**
+ * @brief 在 [begin, end) 中查找, 记录扫描过的字节数
+ * 索引已建立且能用于该特征码时改用索引, 结果与线性扫描相同
+ */
+inline uintptr_t scanRange(const char *szSignature, const uint8_t *begin, const uint8_t *end, FindSigStats *stats)
+{
+    SigPattern pattern(szSignature);
+    const uint8_t *found = nullptr;
+    size_t checked = 0;
+    if (sigIndex().find(pattern, found, &checked)) {
+        if (stats) {
+            stats->indexed = true;
+            stats->bytesScanned = checked * pattern.size();
         }
+        return found ? (uintptr_t)found : 0;
+    }
+    found = pattern.find(begin, end);
+    if (stats) {
+        stats->bytesScanned = found ? (size_t)(found - begin) + pattern.size() : (size_t)(end - begin);
+    }
+    return found ? (uintptr_t)found : 0;
+}
 
-        if (*(PBYTE)pattern == '\?' || *(BYTE *)pCur == patByte) {
-            if (!firstMatch) {
-                firstMatch = pCur;
-            }
-
-            if (!pattern[2] || !pattern[1]) {
-                return firstMatch;
-            }
-
-            pattern += 2;
-        }
-        else {
-            pattern = szSignature;
-            firstMatch = 0;
+// 使用特征码查找地址
+auto findSig(const char *szSignature, FindSigStats *stats = nullptr) -> uintptr_t
+{
+    auto [rangeStart, rangeEnd] = sigSearchRange();
+#ifdef _WIN32
+    if (auto cached = sigCacheLookup(rangeStart, rangeEnd - rangeStart, szSignature)) {
+        if (stats) {
+            stats->cacheHit = true;
         }
+        return cached;
     }
-
-    return 0;
+#endif // _WIN32
+    return scanRange(szSignature, (const uint8_t *)rangeStart, (const uint8_t *)rangeEnd, stats);
 }
 
 /**
  * @brief 从某个给定的地址开始 寻找特征码, 不超过 border 范围
+ * 同一特征码需要多次查找时, 可以先构造 SigPattern 复用跳表
  * @param szPtr 给定的开始地址
- * @param szSignature
+ * @param pattern
  * @param border
  * @return
  */
-uintptr_t FindSignatureRelay(uintptr_t szPtr, const char *szSignature, int border)
+uintptr_t FindSignatureRelay(uintptr_t szPtr, const SigPattern &pattern, int border)
 {
-    // uintptr_t startPtr = szPtr;
-    const char *pattern = szSignature;
-    for (;;) {
-        if (border <= 0) {
-            return 0;
-        }
-        pattern = szSignature;
-        uintptr_t startPtr = szPtr;
-        for (;;) {
-            if (*pattern == ' ') {
-                pattern++;
-            }
-            if (*pattern == '\0') {
-                return szPtr;
-            }
-            if (*pattern == '\?') {
-                pattern++;
-                startPtr++;
-                continue;
-            }
-            if (*(BYTE *)startPtr == GET_BYTE(pattern)) {
-                pattern += 2;
-                startPtr++;
-                continue;
-            }
-            break;
-        }
-        szPtr++;
-        border--;
+    if (border <= 0) {
+        return 0;
     }
-};
+    // 起始位置不超过 border, 但最后一个起始位置的比较可以读到 border 之外
+    auto begin = (const uint8_t *)szPtr;
+    auto found = pattern.find(begin, begin + border + (pattern.empty() ? 0 : pattern.size() - 1));
+    return found ? (uintptr_t)found : 0;
+}
+
+uintptr_t FindSignatureRelay(uintptr_t szPtr, const char *szSignature, int border)
+{
+    return FindSignatureRelay(szPtr, SigPattern(szSignature), border);
+}
 
 /// <summary>
 /// 可在一个函数的调用者处定位这个函数
@@ -226,6 +263,12 @@ public:
      * @param handle 获取成功后 二次处理, 返回值为最终结果
      */
     void AddSignCall(const char *sign, int offset = 1, std::function<uintptr_t(uintptr_t)> handle = nullptr);
+
+private:
+    /**
+     * @brief 调用 findSig 并把这次查找记入启动分析
+     */
+    uintptr_t profiledFind(const char *sign);
 };
 
 SignCode::operator bool() const
@@ -275,7 +318,7 @@ void SignCode::AddSign(const char *sign, std::function<uintptr_t(uintptr_t)> han
     if (success) {
         return;
     }
-    v = findSig(sign);
+    v = profiledFind(sign);
     if (!v) {
 #ifndef INCLIENT
         std::cout << "[SignCode Warn] [" << _printTitle << "] 特征码查找失败:" << findCount << std::endl;
@@ -302,7 +345,7 @@ void SignCode::AddSignCall(const char *sign, int offset, std::function<uintptr_t
     if (success) {
         return;
     }
-    auto _v = findSig(sign);
+    auto _v = profiledFind(sign);
     if (!_v) {
 #ifndef INCLIENT
         std::cout << "[SignCode Warn] [" << _printTitle << "] 特征码查找失败:" << findCount << std::endl;
@@ -324,3 +367,13 @@ void SignCode::AddSignCall(const char *sign, int offset, std::function<uintptr_t
         }
     }
 }
+
+uintptr_t SignCode::profiledFind(const char *sign)
+{
+    FindSigStats stats;
+    auto begin = std::chrono::steady_clock::now();
+    auto found = findSig(sign, &stats);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    startupProfiler().recordSignature({_printTitle, findCount, ms, stats.bytesScanned, stats.cacheHit, stats.indexed, found != 0});
+    return found;
+}
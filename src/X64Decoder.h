@@ -0,0 +1,406 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief 一条 x86-64 指令的长度和各个字段的位置
+ * 只解码 Hook 重定位和生成特征码需要的信息, 不区分具体的操作
+ */
+struct X64Instruction {
+    uint8_t length = 0;
+    /**
+     * @brief 操作码表: 0 单字节, 1 为 0F, 2 为 0F 38, 3 为 0F 3A (VEX/EVEX 使用其中的 map 字段)
+     */
+    uint8_t opcodeMap = 0;
+    uint8_t opcode = 0;
+    uint8_t opcodeOffset = 0;
+    bool hasModrm = false;
+    uint8_t modrm = 0;
+    uint8_t dispOffset = 0;
+    uint8_t dispSize = 0;
+    uint8_t immOffset = 0;
+    uint8_t immSize = 0;
+    /**
+     * @brief disp32 相对于下一条指令地址 (RIP)
+     */
+    bool ripRelative = false;
+    /**
+     * @brief 立即数是相对跳转/调用的偏移 (rel8/rel32)
+     */
+    bool relativeBranch = false;
+};
+
+namespace X64Detail {
+// 单字节操作码的属性
+enum : uint8_t {
+    None = 0,
+    ModRM = 1 << 0,
+    Imm8 = 1 << 1,
+    Imm16 = 1 << 2,
+    ImmZ = 1 << 3, // 16/32 位, 由操作数大小决定
+    Rel8 = 1 << 4,
+    Rel32 = 1 << 5,
+    Invalid = 1 << 6,
+    Prefix = 1 << 7,
+};
+
+inline uint8_t oneByteFlags(uint8_t op)
+{
+    if (op < 0x40) {
+        switch (op & 7) {
+        case 0:
+        case 1:
+        case 2:
+        case 3:
+            return ModRM;
+        case 4:
+            return Imm8;
+        case 5:
+            return ImmZ;
+        default:
+            // 26 2E 36 3E 为段前缀, 其余在 64 位模式下无效 (0F 单独处理)
+            return (op == 0x26 || op == 0x2E || op == 0x36 || op == 0x3E) ? Prefix : Invalid;
+        }
+    }
+    if (op < 0x50) {
+        return Prefix; // REX
+    }
+    if (op < 0x60) {
+        return None;
+    }
+    if (op >= 0x70 && op < 0x80) {
+        return Rel8;
+    }
+    if (op >= 0x84 && op < 0x90) {
+        return ModRM;
+    }
+    if (op >= 0x90 && op < 0xA0) {
+        return op == 0x9A ? Invalid : None;
+    }
+    if (op >= 0xB0 && op < 0xB8) {
+        return Imm8;
+    }
+    if (op >= 0xB8 && op < 0xC0) {
+        return ImmZ;
+    }
+    if (op >= 0xD8 && op < 0xE0) {
+        return ModRM;
+    }
+    switch (op) {
+    case 0x63:
+        return ModRM;
+    case 0x64:
+    case 0x65:
+    case 0x66:
+    case 0x67:
+        return Prefix;
+    case 0x68:
+        return ImmZ;
+    case 0x69:
+        return ModRM | ImmZ;
+    case 0x6A:
+        return Imm8;
+    case 0x6B:
+        return ModRM | Imm8;
+    case 0x6C:
+    case 0x6D:
+    case 0x6E:
+    case 0x6F:
+        return None;
+    case 0x80:
+    case 0x83:
+        return ModRM | Imm8;
+    case 0x81:
+        return ModRM | ImmZ;
+    case 0xA8:
+        return Imm8;
+    case 0xA9:
+        return ImmZ;
+    case 0xA4:
+    case 0xA5:
+    case 0xA6:
+    case 0xA7:
+    case 0xAA:
+    case 0xAB:
+    case 0xAC:
+    case 0xAD:
+    case 0xAE:
+    case 0xAF:
+        return None;
+    case 0xC0:
+    case 0xC1:
+    case 0xC6:
+        return ModRM | Imm8;
+    case 0xC7:
+        return ModRM | ImmZ;
+    case 0xC2:
+    case 0xCA:
+        return Imm16;
+    case 0xC8:
+        return Imm16 | Imm8;
+    case 0xCD:
+        return Imm8;
+    case 0xC3:
+    case 0xC9:
+    case 0xCB:
+    case 0xCC:
+    case 0xCF:
+        return None;
+    case 0xD0:
+    case 0xD1:
+    case 0xD2:
+    case 0xD3:
+        return ModRM;
+    case 0xD7:
+        return None;
+    case 0xE0:
+    case 0xE1:
+    case 0xE2:
+    case 0xE3:
+    case 0xEB:
+        return Rel8;
+    case 0xE4:
+    case 0xE5:
+    case 0xE6:
+    case 0xE7:
+        return Imm8;
+    case 0xE8:
+    case 0xE9:
+        return Rel32;
+    case 0xEC:
+    case 0xED:
+    case 0xEE:
+    case 0xEF:
+    case 0xF1:
+    case 0xF4:
+    case 0xF5:
+    case 0xF8:
+    case 0xF9:
+    case 0xFA:
+    case 0xFB:
+    case 0xFC:
+    case 0xFD:
+        return None;
+    case 0xF0:
+    case 0xF2:
+    case 0xF3:
+        return Prefix;
+    case 0xF6:
+    case 0xF7:
+    case 0xFE:
+    case 0xFF:
+        return ModRM; // F6/F7 的 test 带立即数, 解码 ModRM 后再判断
+    default:
+        return Invalid;
+    }
+}
+
+inline uint8_t twoByteFlags(uint8_t op)
+{
+    if (op >= 0x80 && op < 0x90) {
+        return Rel32;
+    }
+    if (op >= 0xC8 && op < 0xD0) {
+        return None;
+    }
+    if (op >= 0x30 && op < 0x38) {
+        return None;
+    }
+    switch (op) {
+    case 0x05:
+    case 0x06:
+    case 0x07:
+    case 0x08:
+    case 0x09:
+    case 0x0B:
+    case 0x0E:
+    case 0x77:
+    case 0xA0:
+    case 0xA1:
+    case 0xA2:
+    case 0xA8:
+    case 0xA9:
+    case 0xAA:
+        return None;
+    case 0x0F:
+    case 0x70:
+    case 0x71:
+    case 0x72:
+    case 0x73:
+    case 0xA4:
+    case 0xAC:
+    case 0xBA:
+    case 0xC2:
+    case 0xC4:
+    case 0xC5:
+    case 0xC6:
+        return ModRM | Imm8;
+    default:
+        return ModRM;
+    }
+}
+} // namespace X64Detail
+
+/**
+ * @brief 解码 code 处的一条 64 位模式指令
+ * @param available code 之后可读的字节数, 超过 15 时按 15 处理
+ * @return 无法识别或超出可读范围时返回 false
+ */
+inline bool decodeX64(const uint8_t *code, size_t available, X64Instruction &out)
+{
+    using namespace X64Detail;
+    out = X64Instruction{};
+    size_t limit = available < 15 ? available : 15;
+    size_t i = 0;
+    bool operand16 = false;
+    bool address32 = false;
+    bool rexW = false;
+
+    // 前缀, REX 必须紧挨着操作码
+    while (i < limit) {
+        uint8_t b = code[i];
+        if (b >= 0x40 && b < 0x50) {
+            rexW = (b & 8) != 0;
+            i++;
+            if (i < limit && oneByteFlags(code[i]) == Prefix && !(code[i] >= 0x40 && code[i] < 0x50)) {
+                // REX 后面再跟前缀时 REX 被忽略
+                rexW = false;
+                continue;
+            }
+            break;
+        }
+        if (oneByteFlags(b) != Prefix) {
+            break;
+        }
+        operand16 |= b == 0x66;
+        address32 |= b == 0x67;
+        i++;
+    }
+    if (i >= limit) {
+        return false;
+    }
+
+    uint8_t flags = 0;
+    uint8_t op = code[i];
+    if (op == 0xC4 || op == 0xC5 || op == 0x62) {
+        // VEX / EVEX: map 1 的 ModRM 与立即数和 0F 表一致 (除 vzeroupper 外都有 ModRM), map 3 带一个 imm8
+        size_t prefixLength = op == 0xC5 ? 2 : op == 0xC4 ? 3 : 4;
+        if (i + prefixLength >= limit) {
+            return false;
+        }
+        uint8_t map = op == 0xC5 ? 1 : (code[i + 1] & (op == 0x62 ? 0x07 : 0x1F));
+        if (op == 0xC4) {
+            rexW = (code[i + 2] & 0x80) != 0;
+        }
+        i += prefixLength;
+        out.opcodeMap = map;
+        out.opcodeOffset = (uint8_t)i;
+        out.opcode = code[i++];
+        flags = map == 1 ? twoByteFlags(out.opcode) : ModRM | (map == 3 ? Imm8 : 0);
+    }
+    else if (op == 0x0F) {
+        if (++i >= limit) {
+            return false;
+        }
+        uint8_t op2 = code[i];
+        if (op2 == 0x38 || op2 == 0x3A) {
+            if (++i >= limit) {
+                return false;
+            }
+            out.opcodeMap = op2 == 0x38 ? 2 : 3;
+            flags = ModRM | (op2 == 0x3A ? Imm8 : 0);
+        }
+        else {
+            out.opcodeMap = 1;
+            flags = twoByteFlags(op2);
+        }
+        out.opcodeOffset = (uint8_t)i;
+        out.opcode = code[i++];
+    }
+    else {
+        flags = oneByteFlags(op);
+        if (flags & (Invalid | Prefix)) {
+            return false;
+        }
+        out.opcodeOffset = (uint8_t)i;
+        out.opcode = op;
+        i++;
+    }
+
+    if (flags & ModRM) {
+        if (i >= limit) {
+            return false;
+        }
+        uint8_t modrm = code[i++];
+        out.hasModrm = true;
+        out.modrm = modrm;
+        uint8_t mod = modrm >> 6;
+        uint8_t rm = modrm & 7;
+        if (mod != 3) {
+            if (rm == 4) {
+                if (i >= limit) {
+                    return false;
+                }
+                uint8_t sib = code[i++];
+                if (mod == 0 && (sib & 7) == 5) {
+                    out.dispSize = 4;
+                }
+            }
+            else if (mod == 0 && rm == 5) {
+                out.dispSize = 4;
+                out.ripRelative = true;
+            }
+            if (mod == 1) {
+                out.dispSize = 1;
+            }
+            else if (mod == 2) {
+                out.dispSize = 4;
+            }
+        }
+        if (out.dispSize) {
+            out.dispOffset = (uint8_t)i;
+            i += out.dispSize;
+        }
+        // F6 /0 /1 与 F7 /0 /1 (test) 带立即数
+        if (out.opcodeMap == 0 && (op == 0xF6 || op == 0xF7) && ((modrm >> 3) & 7) < 2) {
+            flags |= op == 0xF6 ? Imm8 : ImmZ;
+        }
+    }
+
+    size_t immSize = 0;
+    if (out.opcodeMap == 0 && op >= 0xA0 && op <= 0xA3) {
+        // mov 与 moffs 之间, 偏移为地址大小
+        immSize = address32 ? 4 : 8;
+    }
+    else {
+        if (flags & ImmZ) {
+            if (out.opcodeMap == 0 && op >= 0xB8 && op < 0xC0 && rexW) {
+                immSize += 8;
+            }
+            else {
+                immSize += (operand16 && !rexW) ? 2 : 4;
+            }
+        }
+        if (flags & Imm16) {
+            immSize += 2;
+        }
+        if (flags & (Imm8 | Rel8)) {
+            immSize += 1;
+        }
+        if (flags & Rel32) {
+            immSize += 4;
+        }
+    }
+    if (immSize) {
+        out.immOffset = (uint8_t)i;
+        out.immSize = (uint8_t)immSize;
+        out.relativeBranch = (flags & (Rel8 | Rel32)) != 0;
+        i += immSize;
+    }
+
+    if (i > limit) {
+        return false;
+    }
+    out.length = (uint8_t)i;
+    return true;
+}
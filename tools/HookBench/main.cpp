@@ -0,0 +1,226 @@
+// 检查 Linux Hook 后端能正确挂钩/卸载本地函数, 同一目标上的多个Hook按优先级顺序执行
+// 并测量每次调用经过 Hook 的额外开销
+// 用法: HookBench [调用次数, 默认 50000000]
+
+#define USE_LINUXHOOK
+#include "HookManager/HookManager.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+extern "C" int ripTarget(int x);
+extern "C" int branchTarget(int x);
+extern "C" int addTarget(int x);
+extern "C" int orderTarget(int x);
+extern "C" int ripValue;
+
+// 开头是 RIP 相对寻址和短跳转的函数, 用来检查指令搬移; addTarget 用来测量调用开销
+asm(R"(
+    .data
+    .globl ripValue
+ripValue:
+    .long 1000
+    .text
+    .globl ripTarget
+ripTarget:
+    movl ripValue(%rip), %eax
+    addl %edi, %eax
+    ret
+    .globl branchTarget
+branchTarget:
+    testl %edi, %edi
+    je 1f
+    leal 1(%rdi), %eax
+    ret
+1:
+    movl $-1, %eax
+    ret
+    .globl addTarget
+addTarget:
+    pushq %rbp
+    movq %rsp, %rbp
+    leal 2(%rdi), %eax
+    popq %rbp
+    ret
+    .globl orderTarget
+orderTarget:
+    pushq %rbp
+    movq %rsp, %rbp
+    movl %edi, %eax
+    popq %rbp
+    ret
+)");
+
+HookInstance *hA = nullptr;
+HookInstance *hB = nullptr;
+HookInstance *hC = nullptr;
+HookInstance *hRip = nullptr;
+HookInstance *hBranch = nullptr;
+HookInstance *hLow = nullptr;
+HookInstance *hHigh = nullptr;
+HookInstance *hMid = nullptr;
+HookInstance *hMidLater = nullptr;
+
+/**
+ * @brief orderTarget 上各回调的执行顺序
+ */
+static std::string order;
+
+__attribute__((noinline)) int detourA(int x)
+{
+    return hA->oriForSign(detourA)(x);
+}
+__attribute__((noinline)) int detourB(int x)
+{
+    return hB->oriForSign(detourB)(x);
+}
+__attribute__((noinline)) int detourC(int x)
+{
+    return hC->oriForSign(detourC)(x);
+}
+int detourRip(int x)
+{
+    return hRip->oriForSign(detourRip)(x) * 2;
+}
+int detourBranch(int x)
+{
+    return hBranch->oriForSign(detourBranch)(x) + 100;
+}
+
+__attribute__((noinline)) int detourLow(int x)
+{
+    order += 'L';
+    return hLow->oriForSign(detourLow)(x);
+}
+__attribute__((noinline)) int detourHigh(int x)
+{
+    order += 'H';
+    return hHigh->oriForSign(detourHigh)(x);
+}
+__attribute__((noinline)) int detourMid(int x)
+{
+    order += 'M';
+    return hMid->oriForSign(detourMid)(x);
+}
+__attribute__((noinline)) int detourMidLater(int x)
+{
+    order += 'm';
+    return hMidLater->oriForSign(detourMidLater)(x);
+}
+
+static int failures = 0;
+
+static void expect(const char *what, int got, int want)
+{
+    if (got != want) {
+        std::printf("[FAIL] %s: got %d, want %d\n", what, got, want);
+        failures++;
+    }
+}
+
+/**
+ * @brief 调用 orderTarget, 检查返回值和各回调的执行顺序
+ */
+static void expectOrder(const char *what, const char *want)
+{
+    order.clear();
+    expect(what, orderTarget(7), 7);
+    if (order != want) {
+        std::printf("[FAIL] %s: ran \"%s\", want \"%s\"\n", what, order.c_str(), want);
+        failures++;
+    }
+}
+
+/**
+ * @return 每次调用的平均耗时(纳秒)
+ */
+static double measure(int (*const volatile &fn)(int), long calls)
+{
+    int sink = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (long i = 0; i < calls; i++) {
+        sink += fn((int)i);
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+    asm volatile("" : : "r"(sink));
+    return elapsed / (double)calls;
+}
+
+int main(int argc, char **argv)
+{
+    long calls = argc > 1 ? std::atol(argv[1]) : 50000000;
+    auto manager = HookManager::getInstance();
+    manager->on([](HookManager::msgtype, std::string msg) { std::printf("[HookManager] %s\n", msg.c_str()); });
+
+    hRip = manager->addHook((uintptr_t)&ripTarget, (void *)&detourRip, "ripTarget");
+    hBranch = manager->addHook((uintptr_t)&branchTarget, (void *)&detourBranch, "branchTarget");
+    if (!hRip || !hRip->hook() || !hBranch || !hBranch->hook()) {
+        std::printf("[FAIL] hook relocation targets\n");
+        return 1;
+    }
+    expect("ripTarget hooked", ripTarget(5), 2010);
+    expect("branchTarget hooked, taken", branchTarget(0), 99);
+    expect("branchTarget hooked, not taken", branchTarget(5), 106);
+    hRip->unhook();
+    hBranch->unhook();
+    expect("ripTarget unhooked", ripTarget(5), 1005);
+    expect("branchTarget unhooked", branchTarget(0), -1);
+
+    // 添加顺序与优先级不同; 优先级相同的先添加的先执行
+    hLow = manager->addHook((uintptr_t)&orderTarget, (void *)&detourLow, "low", 0);
+    hMid = manager->addHook((uintptr_t)&orderTarget, (void *)&detourMid, "mid", 2);
+    hHigh = manager->addHook((uintptr_t)&orderTarget, (void *)&detourHigh, "high", 5);
+    hMidLater = manager->addHook((uintptr_t)&orderTarget, (void *)&detourMidLater, "mid later", 2);
+    if (!hLow || !hMid || !hHigh || !hMidLater || !hLow->hook() || !hHigh->hook()) {
+        std::printf("[FAIL] hook orderTarget\n");
+        return 1;
+    }
+    expectOrder("orderTarget, high and low", "HL");
+    hMidLater->hook();
+    hMid->hook();
+    expectOrder("orderTarget, all four", "HMmL");
+    hHigh->unhook();
+    expectOrder("orderTarget, high removed", "MmL");
+    hLow->unhook();
+    hMid->unhook();
+    hMidLater->unhook();
+    expectOrder("orderTarget unhooked", "");
+
+    int (*volatile fn)(int) = &addTarget;
+    double direct = measure(fn, calls);
+
+    hA = manager->addHook((uintptr_t)&addTarget, (void *)&detourA, "A", 2);
+    hB = manager->addHook((uintptr_t)&addTarget, (void *)&detourB, "B", 1);
+    hC = manager->addHook((uintptr_t)&addTarget, (void *)&detourC, "C", 0);
+    if (!hA || !hA->hook()) {
+        std::printf("[FAIL] hook addTarget\n");
+        return 1;
+    }
+    expect("addTarget, 1 hook", addTarget(1), 3);
+    double one = measure(fn, calls);
+    hB->hook();
+    hC->hook();
+    expect("addTarget, 3 hooks", addTarget(1), 3);
+    double three = measure(fn, calls);
+    manager->disableAllHook();
+    expect("addTarget unhooked", addTarget(1), 3);
+    expect("ripTarget unhooked by disableAllHook", ripTarget(5), 1005);
+    manager->enableAllHook();
+    expect("ripTarget rehooked by enableAllHook", ripTarget(5), 2010);
+    expect("addTarget rehooked by enableAllHook", addTarget(1), 3);
+    expect("findHookInstance returns the highest priority", manager->findHookInstance((uintptr_t)&addTarget) == hA, 1);
+    manager->disableAllHook();
+    expect("ripTarget unhooked again", ripTarget(5), 1005);
+
+    std::printf("%-12s %10s %10s\n", "hooks", "ns/call", "overhead");
+    std::printf("%-12s %10.2f %10s\n", "none", direct, "-");
+    std::printf("%-12s %10.2f %10.2f\n", "1", one, one - direct);
+    std::printf("%-12s %10.2f %10.2f\n", "3 (chained)", three, three - direct);
+    if (failures) {
+        std::printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
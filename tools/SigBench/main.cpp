@@ -0,0 +1,200 @@
+// 对比 FindSignatureRelay 原来的逐字节循环与现在的 Horspool 查找: 检查两者结果一致并测量耗时
+// 用法: SigBench [二进制文件, 默认使用 SigBench 自身的代码段] [--patterns 20000] [--border 4096]
+
+#include "Utils.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @brief user-026 之前的 FindSignatureRelay, 原样保留用于对比 (BYTE 换成 uint8_t)
+ */
+static uintptr_t legacyFindSignatureRelay(uintptr_t szPtr, const char *szSignature, int border)
+{
+    const char *pattern = szSignature;
+    for (;;) {
+        if (border <= 0) {
+            return 0;
+        }
+        pattern = szSignature;
+        uintptr_t startPtr = szPtr;
+        for (;;) {
+            if (*pattern == ' ') {
+                pattern++;
+            }
+            if (*pattern == '\0') {
+                return szPtr;
+            }
+            if (*pattern == '\?') {
+                pattern++;
+                startPtr++;
+                continue;
+            }
+            if (*(uint8_t *)startPtr == GET_BYTE(pattern)) {
+                pattern += 2;
+                startPtr++;
+                continue;
+            }
+            break;
+        }
+        szPtr++;
+        border--;
+    }
+}
+
+struct Case {
+    /**
+     * @brief 通配字节写作 ?
+     */
+    std::string single;
+    /**
+     * @brief 同一个特征码, 通配字节写作 ??, 即每个通配位置两个通配字节
+     */
+    std::string doubled;
+    size_t length;
+    size_t start;
+    int border;
+};
+
+static std::vector<uint8_t> loadBuffer(const char *path)
+{
+    if (path) {
+        std::ifstream in(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    }
+    auto [begin, end] = sigSearchRange();
+    return {(const uint8_t *)begin, (const uint8_t *)end};
+}
+
+/**
+ * @brief 从缓冲区中截取特征码, 随机把一些字节换成通配符; 一部分改掉末位字节, 大多找不到
+ */
+static std::vector<Case> makeCases(const std::vector<uint8_t> &buffer, size_t count, int border, std::mt19937_64 &rng)
+{
+    std::vector<Case> cases;
+    for (size_t n = 0; n < count; n++) {
+        size_t length = 4 + rng() % 29;
+        size_t window = (size_t)border + length;
+        if (buffer.size() <= window * 2) {
+            break;
+        }
+        size_t start = rng() % (buffer.size() - window);
+        size_t source = start + rng() % (size_t)border;
+        Case c{{}, {}, length, start, border};
+        char hex[4];
+        for (size_t i = 0; i < length; i++) {
+            if (i) {
+                c.single += ' ';
+                c.doubled += ' ';
+            }
+            uint8_t byte = buffer[source + i];
+            if (i + 1 == length && n % 4 == 0) {
+                byte ^= 0x5A;
+            }
+            // 首字节不做通配, 与原来的循环一样
+            if (i && rng() % 5 == 0) {
+                c.single += '?';
+                c.doubled += "??";
+                continue;
+            }
+            std::snprintf(hex, sizeof(hex), "%02X", byte);
+            c.single += hex;
+            c.doubled += hex;
+        }
+        cases.push_back(std::move(c));
+    }
+    return cases;
+}
+
+template <typename Fn>
+static double timeMs(Fn &&fn)
+{
+    auto begin = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = nullptr;
+    size_t patternCount = 20000;
+    int border = 4096;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--patterns") && i + 1 < argc) {
+            patternCount = (size_t)std::atol(argv[++i]);
+        }
+        else if (!std::strcmp(argv[i], "--border") && i + 1 < argc) {
+            border = std::atoi(argv[++i]);
+        }
+        else {
+            path = argv[i];
+        }
+    }
+    auto buffer = loadBuffer(path);
+    std::mt19937_64 rng(26);
+    auto cases = makeCases(buffer, patternCount, border, rng);
+    if (cases.empty()) {
+        std::printf("[FAIL] buffer of %zu bytes is too small for border %d\n", buffer.size(), border);
+        return 1;
+    }
+    auto base = (uintptr_t)buffer.data();
+
+    int failures = 0;
+    size_t found = 0;
+    for (auto &c : cases) {
+        uintptr_t start = base + c.start;
+        uintptr_t legacy = legacyFindSignatureRelay(start, c.single.c_str(), c.border);
+        uintptr_t current = FindSignatureRelay(start, c.single.c_str(), c.border);
+        found += current != 0;
+        if (legacy != current) {
+            if (failures++ < 10) {
+                std::printf("[FAIL] \"%s\" at +%zu: legacy %+lld, Horspool %+lld\n", c.single.c_str(), c.start,
+                            legacy ? (long long)(legacy - start) : -1LL,
+                            current ? (long long)(current - start) : -1LL);
+            }
+        }
+        // ?? 是两个通配字节, 两种实现必须一致
+        uintptr_t legacyDoubled = legacyFindSignatureRelay(start, c.doubled.c_str(), c.border);
+        uintptr_t currentDoubled = FindSignatureRelay(start, c.doubled.c_str(), c.border);
+        if (legacyDoubled != currentDoubled) {
+            if (failures++ < 10) {
+                std::printf("[FAIL] \"%s\" at +%zu: legacy %+lld, Horspool %+lld\n", c.doubled.c_str(), c.start,
+                            legacyDoubled ? (long long)(legacyDoubled - start) : -1LL,
+                            currentDoubled ? (long long)(currentDoubled - start) : -1LL);
+            }
+        }
+    }
+
+    uintptr_t sink = 0;
+    double legacyMs = timeMs([&] {
+        for (auto &c : cases) {
+            sink += legacyFindSignatureRelay(base + c.start, c.single.c_str(), c.border);
+        }
+    });
+    double currentMs = timeMs([&] {
+        for (auto &c : cases) {
+            sink += FindSignatureRelay(base + c.start, c.single.c_str(), c.border);
+        }
+    });
+    asm volatile("" : : "r"(sink));
+
+    std::printf("%zu patterns (%zu found) over %zu bytes, border %d\n", cases.size(), found, buffer.size(), border);
+    std::printf("%-22s %10s %10s\n", "", "total ms", "us/search");
+    auto row = [&](const char *name, double ms) {
+        std::printf("%-22s %10.2f %10.3f\n", name, ms, ms * 1000 / (double)cases.size());
+    };
+    row("legacy loop", legacyMs);
+    row("Horspool", currentMs);
+    if (failures) {
+        std::printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
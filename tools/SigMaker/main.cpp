@@ -0,0 +1,322 @@
+// 为指定函数生成最短的唯一特征码, 输出格式与 Signatures.h / config.json 中的特征码相同
+// 用法: SigMaker <bedrock_server.exe | bedrock_server> <函数 RVA, 十六进制> [--max-bytes 64] [--slack 16]
+// ELF 文件的 RVA 即相对加载基址的虚拟地址 (与 nm / objdump 显示的地址相同)
+
+#include "PeImage.h"
+#include "X64Decoder.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <elf.h>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * @brief 插件的 findSig 会扫描的一段连续字节
+ */
+struct Region {
+    uint64_t rva;
+    const uint8_t *data;
+    size_t size;
+};
+
+/**
+ * @brief 与插件的查找范围一致: PE 为所有节 (findSig 扫描整个模块), ELF 为第一个可执行段
+ */
+static bool loadRegions(const uint8_t *file, size_t fileSize, std::vector<Region> &regions)
+{
+    PeInfo pe;
+    if (parsePe(file, fileSize, pe)) {
+        std::sort(pe.sections.begin(), pe.sections.end(),
+                  [](const PeSection &a, const PeSection &b) { return a.virtualAddress < b.virtualAddress; });
+        for (auto &section : pe.sections) {
+            if (section.rawOffset >= fileSize) {
+                continue;
+            }
+            size_t length = std::min<size_t>({section.rawSize, section.virtualSize, fileSize - section.rawOffset});
+            regions.push_back({section.virtualAddress, file + section.rawOffset, length});
+        }
+        return true;
+    }
+
+    Elf64_Ehdr ehdr;
+    if (fileSize < sizeof(ehdr)) {
+        return false;
+    }
+    std::memcpy(&ehdr, file, sizeof(ehdr));
+    if (std::memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0 || ehdr.e_ident[EI_CLASS] != ELFCLASS64
+        || ehdr.e_machine != EM_X86_64) {
+        return false;
+    }
+    for (int i = 0; i < ehdr.e_phnum; i++) {
+        Elf64_Phdr phdr;
+        size_t offset = ehdr.e_phoff + (size_t)i * ehdr.e_phentsize;
+        if (offset + sizeof(phdr) > fileSize) {
+            return false;
+        }
+        std::memcpy(&phdr, file + offset, sizeof(phdr));
+        if (phdr.p_type == PT_LOAD && (phdr.p_flags & PF_X) && phdr.p_offset < fileSize) {
+            regions.push_back({phdr.p_vaddr, file + phdr.p_offset,
+                               std::min<size_t>(phdr.p_filesz, fileSize - phdr.p_offset)});
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 函数开头的字节以及哪些字节需要比较
+ */
+struct Candidate {
+    std::vector<uint8_t> bytes;
+    std::vector<uint8_t> fixed;
+};
+
+/**
+ * @brief 逐条解码指令, 把重定位后会变化的操作数标为通配: rel32 跳转/调用, RIP 相对偏移, 64 位绝对地址
+ * 无法解码或函数结束 (ret / jmp / int3) 时在最后一条完整指令处截止, 不跨进相邻的函数
+ */
+static Candidate decodeFunction(const uint8_t *code, size_t available, size_t maxBytes)
+{
+    Candidate out;
+    size_t offset = 0;
+    while (offset < maxBytes && offset < available) {
+        X64Instruction insn;
+        if (!decodeX64(code + offset, available - offset, insn)) {
+            break;
+        }
+        size_t begin = out.bytes.size();
+        out.bytes.insert(out.bytes.end(), code + offset, code + offset + insn.length);
+        out.fixed.insert(out.fixed.end(), insn.length, 1);
+        auto wildcard = [&](size_t at, size_t size) {
+            std::fill_n(out.fixed.begin() + (ptrdiff_t)(begin + at), size, 0);
+        };
+        if (insn.ripRelative) {
+            wildcard(insn.dispOffset, 4);
+        }
+        if (insn.relativeBranch && insn.immSize == 4) {
+            wildcard(insn.immOffset, 4);
+        }
+        if (insn.immSize == 8) {
+            // mov r64, imm64 通常是需要重定位的绝对地址
+            wildcard(insn.immOffset, 8);
+        }
+        offset += insn.length;
+        bool ends = insn.opcodeMap == 0
+                 && (insn.opcode == 0xC3 || insn.opcode == 0xC2 || insn.opcode == 0xCC || insn.opcode == 0xE9
+                     || insn.opcode == 0xEB || (insn.opcode == 0xFF && ((insn.modrm >> 3) & 7) == 4));
+        if (ends) {
+            break;
+        }
+    }
+    if (out.bytes.size() > maxBytes) {
+        out.bytes.resize(maxBytes);
+        out.fixed.resize(maxBytes);
+    }
+    return out;
+}
+
+/**
+ * @brief 逐字节延长前缀, 每次用新的字节过滤候选位置, 只剩目标本身时即为最短的唯一前缀
+ * @return 最短唯一前缀的长度, 在可用字节内无法唯一时返回 0
+ */
+static size_t shortestUnique(const std::vector<Region> &regions, const Candidate &sig)
+{
+    struct Position {
+        const uint8_t *p;
+        const uint8_t *end;
+    };
+    std::vector<Position> positions;
+    for (auto &region : regions) {
+        auto end = region.data + region.size;
+        for (auto p = region.data; p < end; p++) {
+            if (*p == sig.bytes[0]) {
+                positions.push_back({p, end});
+            }
+        }
+    }
+    for (size_t k = 1; k <= sig.bytes.size(); k++) {
+        if (positions.size() <= 1 && sig.fixed[k - 1]) {
+            return positions.size() == 1 ? k : 0;
+        }
+        if (k == sig.bytes.size()) {
+            break;
+        }
+        std::erase_if(positions, [&](const Position &pos) {
+            return pos.p + k >= pos.end || (sig.fixed[k] && pos.p[k] != sig.bytes[k]);
+        });
+    }
+    return 0;
+}
+
+/**
+ * @brief 按 SigPattern 的 Horspool 跳表估算每次比较平均能跳过的字节数, 末位字节越少见跳得越远
+ */
+static double expectedShift(const Candidate &sig, size_t length, const std::array<double, 256> &frequency)
+{
+    size_t base = length;
+    for (size_t i = 0; i + 1 < length; i++) {
+        if (!sig.fixed[i]) {
+            base = length - 1 - i;
+        }
+    }
+    std::array<size_t, 256> shift;
+    shift.fill(base);
+    for (size_t i = 0; i + 1 < length; i++) {
+        if (sig.fixed[i] && length - 1 - i < shift[sig.bytes[i]]) {
+            shift[sig.bytes[i]] = length - 1 - i;
+        }
+    }
+    double expected = 0;
+    for (size_t c = 0; c < 256; c++) {
+        expected += frequency[c] * (double)shift[c];
+    }
+    return expected;
+}
+
+/**
+ * @brief 最长的连续非通配段, 至少 7 字节时可以使用插件的 n-gram 索引 (sigIndex)
+ */
+static size_t longestFixedRun(const Candidate &sig, size_t length)
+{
+    size_t best = 0;
+    for (size_t i = 0, run = 0; i < length; i++) {
+        run = sig.fixed[i] ? run + 1 : 0;
+        best = std::max(best, run);
+    }
+    return best;
+}
+
+static std::string format(const Candidate &sig, size_t length)
+{
+    std::string out;
+    char hex[4];
+    for (size_t i = 0; i < length; i++) {
+        if (i) {
+            out += ' ';
+        }
+        if (sig.fixed[i]) {
+            std::snprintf(hex, sizeof(hex), "%02X", sig.bytes[i]);
+            out += hex;
+        }
+        else {
+            out += '?';
+        }
+    }
+    return out;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: %s <binary> <function rva, hex> [--max-bytes 64] [--slack 16]\n", argv[0]);
+        return 2;
+    }
+    uint64_t rva = std::strtoull(argv[2], nullptr, 16);
+    size_t maxBytes = 64;
+    size_t slack = 16;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        if (!std::strcmp(argv[i], "--max-bytes")) {
+            maxBytes = (size_t)std::atoi(argv[i + 1]);
+        }
+        else if (!std::strcmp(argv[i], "--slack")) {
+            slack = (size_t)std::atoi(argv[i + 1]);
+        }
+    }
+
+    int fd = open(argv[1], O_RDONLY);
+    struct stat st {};
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+        std::perror(argv[1]);
+        return 2;
+    }
+    size_t fileSize = (size_t)st.st_size;
+    auto file = (const uint8_t *)mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (file == MAP_FAILED) {
+        std::perror("mmap");
+        return 2;
+    }
+
+    std::vector<Region> regions;
+    if (!loadRegions(file, fileSize, regions)) {
+        std::fprintf(stderr, "%s: not a PE32+ or x86-64 ELF image\n", argv[1]);
+        return 2;
+    }
+    const Region *home = nullptr;
+    for (auto &region : regions) {
+        if (rva >= region.rva && rva < region.rva + region.size) {
+            home = &region;
+        }
+    }
+    if (!home) {
+        std::fprintf(stderr, "RVA 0x%llX is outside the scanned range\n", (unsigned long long)rva);
+        return 2;
+    }
+
+    auto code = home->data + (rva - home->rva);
+    auto sig = decodeFunction(code, home->size - (size_t)(rva - home->rva), maxBytes);
+    if (sig.bytes.empty()) {
+        std::fprintf(stderr, "cannot decode the instruction at RVA 0x%llX\n", (unsigned long long)rva);
+        return 1;
+    }
+    size_t shortest = shortestUnique(regions, sig);
+    if (!shortest) {
+        if (sig.bytes.size() < maxBytes) {
+            // 函数在 maxBytes 之前就结束了 (或遇到无法解码的指令), 加大 --max-bytes 也没有用
+            std::fprintf(stderr, "no unique signature: the function body ends after %zu bytes, "
+                                 "sign a caller or a longer function instead\n",
+                         sig.bytes.size());
+        }
+        else {
+            std::fprintf(stderr, "no unique signature within %zu bytes, try a larger --max-bytes\n", sig.bytes.size());
+        }
+        return 1;
+    }
+
+    std::array<double, 256> frequency{};
+    size_t total = 0;
+    for (auto &region : regions) {
+        for (size_t i = 0; i < region.size; i++) {
+            frequency[region.data[i]]++;
+        }
+        total += region.size;
+    }
+    for (auto &f : frequency) {
+        f /= (double)total;
+    }
+
+    // 在最短长度之后 slack 字节内, 挑末位字节最少见 (平均跳得最远) 的长度, 扫描更快
+    size_t fastest = shortest;
+    double bestShift = expectedShift(sig, shortest, frequency);
+    for (size_t length = shortest + 1; length <= std::min(sig.bytes.size(), shortest + slack); length++) {
+        if (!sig.fixed[length - 1]) {
+            continue;
+        }
+        double shift = expectedShift(sig, length, frequency);
+        if (shift > bestShift * 1.1) {
+            fastest = length;
+            bestShift = shift;
+        }
+    }
+
+    auto describe = [&](const char *label, size_t length) {
+        double shift = expectedShift(sig, length, frequency);
+        std::printf("%-9s %2zu bytes, ~%.1f bytes skipped per step, %s\n          %s\n", label, length, shift,
+                    longestFixedRun(sig, length) >= 7 ? "usable with sigIndex" : "too short for sigIndex",
+                    format(sig, length).c_str());
+    };
+    describe("shortest", shortest);
+    if (fastest != shortest) {
+        describe("fastest", fastest);
+    }
+    munmap((void *)file, fileSize);
+    return 0;
+}
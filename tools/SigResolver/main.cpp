@@ -0,0 +1,108 @@
+// 离线解析 bedrock_server.exe 中所有已登记的特征码, 生成 src/SigCache.generated.h
+// 用法: SigResolver <bedrock_server.exe> [输出文件, 默认 stdout]
+
+#include "PeImage.h"
+#include "SigPattern.h"
+#include "Signatures.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief 按内存中的布局顺序在各个节里查找, 与插件内 findSig 的首个匹配一致
+ * @return 匹配处的 RVA, 没找到返回 0
+ */
+static uint32_t resolve(const uint8_t *file, size_t fileSize, const PeInfo &info, const SigPattern &pattern)
+{
+    for (auto &section : info.sections) {
+        if (section.rawOffset >= fileSize) {
+            continue;
+        }
+        size_t length = std::min<size_t>({section.rawSize, section.virtualSize, fileSize - section.rawOffset});
+        auto begin = file + section.rawOffset;
+        if (auto found = pattern.find(begin, begin + length)) {
+            return section.virtualAddress + (uint32_t)(found - begin);
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <bedrock_server.exe> [output.h]\n", argv[0]);
+        return 2;
+    }
+
+    int fd = open(argv[1], O_RDONLY);
+    struct stat st {};
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+        std::perror(argv[1]);
+        return 2;
+    }
+    size_t fileSize = (size_t)st.st_size;
+    auto file = (const uint8_t *)mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (file == MAP_FAILED) {
+        std::perror("mmap");
+        return 2;
+    }
+
+    PeInfo info;
+    if (!parsePe(file, fileSize, info)) {
+        std::fprintf(stderr, "%s: not a PE32+ image\n", argv[1]);
+        return 2;
+    }
+    std::sort(info.sections.begin(), info.sections.end(),
+              [](const PeSection &a, const PeSection &b) { return a.virtualAddress < b.virtualAddress; });
+
+    std::string out;
+    out += "// Generated by tools/SigResolver, do not edit.\n";
+    out += "// Source: " + std::string(argv[1]) + "\n";
+    out += "#pragma once\n\n";
+    char line[512];
+    std::snprintf(line, sizeof(line), "inline constexpr PeBuildId sigCacheBuildId{0x%08X, 0x%08X, 0x%08X};\n",
+                  info.buildId.timeDateStamp, info.buildId.sizeOfImage, info.buildId.checkSum);
+    out += line;
+    out += "inline constexpr SigCacheEntry sigCacheEntries[] = {\n";
+
+    int missing = 0;
+    int found = 0;
+    for (auto &sig : Sigs::all) {
+        if (!sig.pattern) {
+            std::fprintf(stderr, "[skipped] %s (no built-in pattern)\n", sig.name);
+            continue;
+        }
+        uint32_t rva = resolve(file, fileSize, info, SigPattern(sig.pattern));
+        if (!rva) {
+            std::fprintf(stderr, "[missing] %s\n", sig.name);
+            missing++;
+            continue;
+        }
+        std::fprintf(stderr, "[found]   %s at RVA 0x%X\n", sig.name, rva);
+        std::snprintf(line, sizeof(line), "    {\"%s\", 0x%X}, // %s\n", sig.pattern, rva, sig.name);
+        out += line;
+        found++;
+    }
+    if (found == 0) {
+        out += "    {nullptr, 0},\n";
+    }
+    out += "};\n";
+    munmap((void *)file, fileSize);
+
+    FILE *dst = argc > 2 ? std::fopen(argv[2], "w") : stdout;
+    if (!dst) {
+        std::perror(argv[2]);
+        return 2;
+    }
+    std::fputs(out.c_str(), dst);
+    if (dst != stdout) {
+        std::fclose(dst);
+    }
+    return missing ? 1 : 0;
+}
@@ -0,0 +1,280 @@
+// 把插件录制的 trace 回放到模拟的 ServerMapDataManager 上, 比较各清理策略对 tick 耗时的影响
+// 模拟对象按 MapLayout 中的偏移布局, 清理通过与插件相同的 CleanupRegistry 和内置规则进行
+// trace 中的 R 事件 (插件在离开之外移除的跟踪者) 直接作用在模拟数据上, 不计入耗时
+// 用法: TraceReplay <trace.log> [--tick-base-ms 40] [--rebuild-seconds 300] [--bloom-bits 65536] [--bloom-hashes 4]
+
+#include "CleanupRules.h"
+#include "MapData.h"
+#include "Trace.h"
+#include "TrackerFilter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+struct MockMapData {
+    alignas(8) std::byte pad[0x60];
+    TrackerList trackers;
+};
+
+struct MockTracker {
+    alignas(8) std::byte pad[0x8];
+    ActorUniqueID id;
+};
+
+/**
+ * @brief 地图数据表位于 0x70 的模拟 ServerMapDataManager
+ * MapDataMap 中的 unique_ptr 并不拥有对象, 析构前全部 release
+ */
+struct MockManager {
+    alignas(8) std::byte pad[0x70];
+    MapDataMap maps;
+    std::vector<std::unique_ptr<MockMapData>> storage;
+
+    ~MockManager()
+    {
+        for (auto &[id, data] : maps) {
+            data.release();
+        }
+    }
+
+    ServerMapDataManager *get()
+    {
+        return (ServerMapDataManager *)this;
+    }
+
+    void addTracker(uint64_t mapKey, int64_t uniqueId)
+    {
+        auto &slot = maps[ActorUniqueID{(int64_t)mapKey}];
+        if (!slot) {
+            storage.push_back(std::make_unique<MockMapData>());
+            slot.reset((MapItemSavedData *)storage.back().get());
+        }
+        auto &trackers = MapLayout::trackers(slot.get());
+        // 与 addTrackedMapEntity 一样, 已在跟踪的实体不会重复添加
+        for (auto &tracker : trackers) {
+            if (MapLayout::trackedId(tracker.get()) == uniqueId) {
+                return;
+            }
+        }
+        auto owner = std::make_shared<MockTracker>();
+        owner->id.id = uniqueId;
+        trackers.emplace_back(owner, (MapItemTrackedActor *)owner.get());
+    }
+
+    void removeTracker(uint64_t mapKey, int64_t uniqueId)
+    {
+        auto it = maps.find(ActorUniqueID{(int64_t)mapKey});
+        if (it == maps.end()) {
+            return;
+        }
+        std::erase_if(MapLayout::trackers(it->second.get()),
+                      [uniqueId](auto &tracker) { return MapLayout::trackedId(tracker.get()) == uniqueId; });
+    }
+};
+
+/**
+ * @brief 当前回放使用的过滤器, 供清理规则的快速判断 (函数指针, 不能捕获) 使用
+ */
+static TrackerFilter *activeFilter = nullptr;
+
+enum class Strategy {
+    Inline,
+    Bloom,
+    Deferred,
+};
+
+struct Options {
+    double tickBaseMs = 40;
+    int rebuildSeconds = 300;
+    int bloomBits = 1 << 16;
+    int bloomHashes = 4;
+};
+
+struct Report {
+    const char *name = "";
+    size_t sweeps = 0;
+    size_t skipped = 0;
+    size_t removed = 0;
+    size_t ticks = 0;
+    double totalUs = 0;
+    std::vector<double> tickCostUs;
+    size_t overruns = 0;
+};
+
+static constexpr int64_t tickUs = 50000;
+
+static Report replay(const std::vector<TraceRecord> &trace, Strategy strategy, const Options &options)
+{
+    Report report;
+    report.name = strategy == Strategy::Inline ? "inline" : strategy == Strategy::Bloom ? "bloom" : "deferred";
+
+    MockManager manager;
+    TrackerFilter filter;
+    bool useFilter = strategy != Strategy::Inline;
+    // 与插件 onLoad 中相同的注册方式
+    CleanupRegistry registry;
+    registerBuiltinRules(registry);
+    if (useFilter) {
+        filter.configure(options.bloomBits, options.bloomHashes);
+        filter.setHookInstalled();
+        filter.rebuild(manager.get());
+        activeFilter = &filter;
+        mapTrackers(registry).setPrefilter([](const CleanupContext &ctx) {
+            return ctx.target == CleanupTarget::Block || activeFilter->mayTrack(ctx.uniqueId);
+        });
+    }
+
+    std::map<int64_t, double> costs;
+    std::vector<int64_t> pending;
+    int64_t currentTick = trace.empty() ? 0 : trace.front().timeUs / tickUs;
+    int64_t nextRebuildUs = (int64_t)options.rebuildSeconds * 1000000;
+
+    auto timed = [&](int64_t tick, auto &&fn) {
+        auto begin = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        costs[tick] += std::chrono::duration<double, std::micro>(end - begin).count();
+    };
+    auto cleanup = [&](int64_t uniqueId) {
+        CleanupContext ctx{nullptr, manager.get(), uniqueId};
+        ctx.playerLeft = true;
+        auto result = registry.run(ctx);
+        if (!result.sweeps) {
+            report.skipped++;
+            return;
+        }
+        report.sweeps += result.sweeps;
+        report.removed += result.removed;
+    };
+    auto endTick = [&](int64_t tick) {
+        if (pending.empty()) {
+            return;
+        }
+        timed(tick, [&] {
+            for (auto id : pending) {
+                cleanup(id);
+            }
+        });
+        pending.clear();
+    };
+
+    for (auto &record : trace) {
+        int64_t tick = record.timeUs / tickUs;
+        if (tick != currentTick) {
+            endTick(currentTick);
+            currentTick = tick;
+        }
+        if (useFilter && record.timeUs >= nextRebuildUs) {
+            timed(tick, [&] { filter.rebuild(manager.get()); });
+            nextRebuildUs = record.timeUs + (int64_t)options.rebuildSeconds * 1000000;
+        }
+        switch (record.type) {
+        case TraceEvent::Join:
+            break;
+        case TraceEvent::TrackerAdd:
+            manager.addTracker(record.mapKey, record.uniqueId);
+            if (useFilter) {
+                timed(tick, [&] { filter.onTrackerAdded(record.uniqueId); });
+            }
+            break;
+        case TraceEvent::TrackerRemove:
+            manager.removeTracker(record.mapKey, record.uniqueId);
+            break;
+        case TraceEvent::Leave:
+            if (strategy == Strategy::Deferred) {
+                timed(tick, [&] { pending.push_back(record.uniqueId); });
+            }
+            else {
+                timed(tick, [&] { cleanup(record.uniqueId); });
+            }
+            break;
+        }
+    }
+    endTick(currentTick);
+    activeFilter = nullptr;
+
+    for (auto &[tick, cost] : costs) {
+        report.tickCostUs.push_back(cost);
+        report.totalUs += cost;
+        if (options.tickBaseMs * 1000 + cost > tickUs) {
+            report.overruns++;
+        }
+    }
+    std::sort(report.tickCostUs.begin(), report.tickCostUs.end());
+    report.ticks = report.tickCostUs.size();
+    return report;
+}
+
+static double percentile(const std::vector<double> &sorted, double p)
+{
+    if (sorted.empty()) {
+        return 0;
+    }
+    return sorted[std::min(sorted.size() - 1, (size_t)(p * (double)(sorted.size() - 1) + 0.5))];
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr,
+                     "usage: %s <trace.log> [--tick-base-ms 40] [--rebuild-seconds 300] [--bloom-bits 65536] "
+                     "[--bloom-hashes 4]\n",
+                     argv[0]);
+        return 2;
+    }
+    Options options;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (!std::strcmp(argv[i], "--tick-base-ms")) {
+            options.tickBaseMs = std::atof(argv[i + 1]);
+        }
+        else if (!std::strcmp(argv[i], "--rebuild-seconds")) {
+            options.rebuildSeconds = std::atoi(argv[i + 1]);
+        }
+        else if (!std::strcmp(argv[i], "--bloom-bits")) {
+            options.bloomBits = std::atoi(argv[i + 1]);
+        }
+        else if (!std::strcmp(argv[i], "--bloom-hashes")) {
+            options.bloomHashes = std::atoi(argv[i + 1]);
+        }
+        else {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    std::ifstream in(argv[1]);
+    if (!in) {
+        std::perror(argv[1]);
+        return 2;
+    }
+    std::vector<TraceRecord> trace;
+    std::string line;
+    while (std::getline(in, line)) {
+        TraceRecord record;
+        if (parseTraceRecord(line, record)) {
+            trace.push_back(record);
+        }
+    }
+    std::stable_sort(trace.begin(), trace.end(),
+                     [](const TraceRecord &a, const TraceRecord &b) { return a.timeUs < b.timeUs; });
+    std::printf("%zu events, tick base %.1f ms\n\n", trace.size(), options.tickBaseMs);
+
+    std::printf("%-9s %8s %8s %9s %7s %10s %10s %10s %10s %9s\n", "strategy", "sweeps", "skipped", "removed",
+                "ticks", "total ms", "p50 us", "p99 us", "max us", "overruns");
+    for (auto strategy : {Strategy::Inline, Strategy::Bloom, Strategy::Deferred}) {
+        auto report = replay(trace, strategy, options);
+        std::printf("%-9s %8zu %8zu %9zu %7zu %10.2f %10.1f %10.1f %10.1f %9zu\n", report.name, report.sweeps,
+                    report.skipped, report.removed, report.ticks, report.totalUs / 1000,
+                    percentile(report.tickCostUs, 0.5), percentile(report.tickCostUs, 0.99),
+                    report.tickCostUs.empty() ? 0.0 : report.tickCostUs.back(), report.overruns);
+    }
+    return 0;
+}
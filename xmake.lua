@@ -27,18 +27,27 @@ add_requires(
     "concurrentqueue 1.0.4",
     "endstone 0.5.7.1",
     "magic_enum 0.9.7",
-    "fmt >=10.0.0 <11.0.0",
-    "lighthook"
+    "fmt >=10.0.0 <11.0.0"
 )
+if not is_plat("linux") then
+    add_requires("lighthook")
+end
 
 target("ChunkLeakFix")
     set_kind("shared")
     add_defines(
         "NOMINMAX",
         "UNICODE",
-        "_AMD64_",
-        "USE_LIGHTHOOK"
+        "_AMD64_"
     )
+    if is_plat("linux") then
+        -- Linux 使用 src/HookManager/LinuxHook.hpp
+        add_defines("USE_LINUXHOOK")
+        add_cxflags("-fdeclspec")
+    else
+        add_defines("USE_LIGHTHOOK")
+        add_packages("lighthook")
+    end
     add_files("src/**.cpp")
     add_includedirs("src")
     add_packages(
@@ -51,9 +60,8 @@ target("ChunkLeakFix")
         "glm",
         "concurrentqueue",
         "endstone",
-        "magic_enum",
-        "lighthook"
-    )  
+        "magic_enum"
+    )
     add_cxflags(
         "/EHa",
         "/utf-8",
@@ -63,10 +71,57 @@ target("ChunkLeakFix")
         "/w44296",
         "/w45263",
         "/w44738",
-        "/w45204"
+        "/w45204",
+        {tools = {"cl", "clang_cl"}}
     )
     set_languages("c++20")
     set_symbols("debug")
     add_defines("ENTT_SPARSE_PAGE=2048")
     add_defines("ENTT_PACKED_PAGE=128")
-    set_exceptions("none")
\ No newline at end of file
+    set_exceptions("none")
+
+-- 离线特征码解析工具, 在 Linux CI 中运行: xmake build SigResolver
+target("SigResolver")
+    set_kind("binary")
+    set_default(false)
+    add_files("tools/SigResolver/*.cpp")
+    add_includedirs("src")
+    set_languages("c++20")
+
+-- 回放插件录制的 trace, 比较各清理策略的 tick 耗时: xmake build TraceReplay
+target("TraceReplay")
+    set_kind("binary")
+    set_default(false)
+    add_files("tools/TraceReplay/*.cpp")
+    add_includedirs("src")
+    set_languages("c++20")
+
+-- Linux Hook 后端的正确性检查和调用开销测量: xmake build HookBench && xmake run HookBench
+if is_plat("linux") then
+    target("HookBench")
+        set_kind("binary")
+        set_default(false)
+        add_files("tools/HookBench/*.cpp")
+        add_includedirs("src")
+        set_languages("c++20")
+end
+
+-- 为函数生成最短的唯一特征码: xmake build SigMaker && xmake run SigMaker <binary> <rva>
+if is_plat("linux") then
+    target("SigMaker")
+        set_kind("binary")
+        set_default(false)
+        add_files("tools/SigMaker/*.cpp")
+        add_includedirs("src")
+        set_languages("c++20")
+end
+
+-- FindSignatureRelay 原逐字节循环与 Horspool 查找的一致性检查和耗时对比: xmake build SigBench && xmake run SigBench
+if is_plat("linux") then
+    target("SigBench")
+        set_kind("binary")
+        set_default(false)
+        add_files("tools/SigBench/*.cpp")
+        add_includedirs("src")
+        set_languages("c++20")
+end